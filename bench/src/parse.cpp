@@ -0,0 +1,353 @@
+#include <benchmark/benchmark.h>
+#include <ulib/json.h>
+#include <ulib/json_struct.h>
+
+#include <string>
+#include <vector>
+
+struct parent_record
+{
+    int64_t id;
+};
+
+ULIB_JSON_STRUCT(parent_record, id)
+
+struct record
+{
+    int64_t id;
+    std::string name;
+    bool active;
+    double score;
+    std::vector<std::string> tags;
+    parent_record parent;
+};
+
+ULIB_JSON_STRUCT(record, id, name, active, score, tags, parent)
+
+// Documents are generated so the results don't depend on files next to the binary
+
+// depth nested arrays, each holding a number before the next level
+static std::string nested_document(size_t depth)
+{
+    std::string str;
+    for (size_t i = 0; i != depth; i++)
+        str += "[1,";
+
+    str += "0";
+    str += std::string(depth, ']');
+    return str;
+}
+
+// records like an API response: shallow objects with short strings and numbers
+static std::string records_document(size_t count)
+{
+    std::string str = "[";
+    for (size_t i = 0; i != count; i++)
+    {
+        if (i)
+            str += ",";
+
+        str += R"({"id":)" + std::to_string(i) + R"(,"name":"user)" + std::to_string(i) +
+               R"(","active":true,"score":)" + std::to_string(i * 0.25) + R"(,"tags":["a","b"],"parent":{"id":)" +
+               std::to_string(i / 2) + "}}";
+    }
+
+    str += "]";
+    return str;
+}
+
+// a flat array of integers and decimals
+static std::string numbers_document(size_t count)
+{
+    std::string str = "[";
+    for (size_t i = 0; i != count; i++)
+        str += (i ? "," : "") + (i % 2 ? std::to_string(i * 3) : std::to_string(i * 0.5));
+
+    str += "]";
+    return str;
+}
+
+// a flat array of strings like ids and enum values, all shorter than 14 bytes
+static std::string short_strings_document(size_t count)
+{
+    std::string str = "[";
+    for (size_t i = 0; i != count; i++)
+        str += (i ? ",\"" : "\"") + std::string(i % 3 ? "id-" : "state_") + std::to_string(i) + "\"";
+
+    str += "]";
+    return str;
+}
+
+static void run_parse(benchmark::State &state, const std::string &str,
+                      const ulib::json::parse_options &options = {})
+{
+    ulib::json::parser parser{options};
+    ulib::json value;
+    for (auto _ : state)
+    {
+        parser.parse(str, value);
+        benchmark::DoNotOptimize(value);
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations() * str.size()));
+}
+
+static void BM_ParseNested(benchmark::State &state)
+{
+    run_parse(state, nested_document(size_t(state.range(0))));
+}
+
+static void BM_ParseRecords(benchmark::State &state)
+{
+    run_parse(state, records_document(size_t(state.range(0))));
+}
+
+// the same document parsed again into the previous tree
+static void BM_ParseRecordsReuse(benchmark::State &state)
+{
+    ulib::json::parse_options options;
+    options.reuse_storage = true;
+    run_parse(state, records_document(size_t(state.range(0))), options);
+}
+
+// typed decoding the two step way: a tree, then every field copied out with get<T>()
+static void BM_ParseRecordsGet(benchmark::State &state)
+{
+    std::string str = records_document(size_t(state.range(0)));
+    ulib::json::parser parser;
+    ulib::json value;
+    std::vector<record> out;
+    for (auto _ : state)
+    {
+        parser.parse(str, value);
+        out.clear();
+        for (auto &item : value.values())
+        {
+            record &r = out.emplace_back();
+            r.id = item["id"].get<int64_t>();
+            r.name = item["name"].get<std::string>();
+            r.active = item["active"].get<bool>();
+            r.score = item["score"].get<double>();
+            r.tags.clear();
+            for (auto &tag : item["tags"].values())
+                r.tags.push_back(tag.get<std::string>());
+            r.parent.id = item["parent"]["id"].get<int64_t>();
+        }
+
+        benchmark::DoNotOptimize(out);
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations() * str.size()));
+}
+
+// the same document written to the tape of a kept tape_document
+static void BM_ParseRecordsTape(benchmark::State &state)
+{
+    std::string str = records_document(size_t(state.range(0)));
+    ulib::json::tape_document doc;
+    for (auto _ : state)
+    {
+        doc.parse(str);
+        benchmark::DoNotOptimize(doc.tape_size());
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations() * str.size()));
+}
+
+// BM_ParseRecordsGet reading the fields from the tape
+static void BM_ParseRecordsTapeGet(benchmark::State &state)
+{
+    std::string str = records_document(size_t(state.range(0)));
+    ulib::json::tape_document doc;
+    std::vector<record> out;
+    for (auto _ : state)
+    {
+        doc.parse(str);
+        out.clear();
+        for (auto &item : doc.root().values())
+        {
+            record &r = out.emplace_back();
+            r.id = item["id"].get<int64_t>();
+            r.name = item["name"].get<std::string>();
+            r.active = item["active"].get<bool>();
+            r.score = item["score"].get<double>();
+            r.tags.clear();
+            for (auto &tag : item["tags"].values())
+                r.tags.push_back(tag.get<std::string>());
+            r.parent.id = item["parent"]["id"].get<int64_t>();
+        }
+
+        benchmark::DoNotOptimize(out);
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations() * str.size()));
+}
+
+static void BM_ParseRecordsInto(benchmark::State &state)
+{
+    std::string str = records_document(size_t(state.range(0)));
+    ulib::json::parser parser;
+    std::vector<record> out;
+    for (auto _ : state)
+    {
+        parser.parse_into(str, out);
+        benchmark::DoNotOptimize(out);
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations() * str.size()));
+}
+
+// one field of every record, the rest of the document is skipped
+static void BM_SelectRecords(benchmark::State &state)
+{
+    std::string str = records_document(size_t(state.range(0)));
+    ulib::json::parser parser;
+    ulib::json::path_set paths{"/*/parent/id"};
+    for (auto _ : state)
+    {
+        int64_t sum = 0;
+        parser.select(str, paths, [&](size_t, ulib::json &value) { return sum += value.get<int64_t>(), true; });
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations() * str.size()));
+}
+
+// the whole document passed over without building it
+static void BM_SkipRecords(benchmark::State &state)
+{
+    std::string str = records_document(size_t(state.range(0)));
+    ulib::json::parser parser;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(parser.skip(str));
+
+    state.SetBytesProcessed(int64_t(state.iterations() * str.size()));
+}
+
+// one large top level array split over range(1) threads
+static void BM_ParseRecordsParallel(benchmark::State &state)
+{
+    std::string str = records_document(size_t(state.range(0)));
+    ulib::json::parser parser;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(parser.parse_parallel(str, size_t(state.range(1))));
+
+    state.SetBytesProcessed(int64_t(state.iterations() * str.size()));
+}
+
+// arena bytes of a parsed document per element, documents lay nodes out like the trees they hold
+static void report_footprint(benchmark::State &state, const std::string &str, size_t count)
+{
+    ulib::json::document doc;
+    doc.parse(str);
+    state.counters["bytes_per_value"] = double(doc.capacity()) / double(count);
+}
+
+static void BM_ParseNumbers(benchmark::State &state)
+{
+    std::string str = numbers_document(size_t(state.range(0)));
+    run_parse(state, str);
+    report_footprint(state, str, size_t(state.range(0)));
+}
+
+static void BM_ParseShortStrings(benchmark::State &state)
+{
+    std::string str = short_strings_document(size_t(state.range(0)));
+    run_parse(state, str);
+    report_footprint(state, str, size_t(state.range(0)));
+}
+
+static void BM_ParseNumbersLazy(benchmark::State &state)
+{
+    std::string str = numbers_document(size_t(state.range(0)));
+    ulib::json::parse_options options;
+    options.numbers = ulib::json::number_mode::lazy;
+    run_parse(state, str, options);
+}
+
+// parse and dump, range(1): number_mode::lazy
+static void BM_RoundTripNumbers(benchmark::State &state)
+{
+    std::string str = numbers_document(size_t(state.range(0)));
+    ulib::json::parse_options options;
+    if (state.range(1))
+        options.numbers = ulib::json::number_mode::lazy;
+
+    for (auto _ : state)
+    {
+        auto value = ulib::json::parse(str, options);
+        benchmark::DoNotOptimize(value.dump());
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations() * str.size()));
+}
+
+// one pass over the parsed numbers, bound by how many nodes fit in cache
+static void BM_SumNumbers(benchmark::State &state)
+{
+    ulib::json value = ulib::json::parse(numbers_document(size_t(state.range(0))));
+    for (auto _ : state)
+    {
+        double sum = 0;
+        for (auto &number : value.values())
+            sum += number.get<double>();
+
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations() * state.range(0)));
+}
+
+static void BM_SumNumbersTape(benchmark::State &state)
+{
+    ulib::json::tape_document doc;
+    doc.parse(numbers_document(size_t(state.range(0))));
+    for (auto _ : state)
+    {
+        double sum = 0;
+        for (auto &number : doc.root().values())
+            sum += number.get<double>();
+
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations() * state.range(0)));
+}
+
+// every key of one object of range(0) items looked up by name
+static void BM_FindKeys(benchmark::State &state)
+{
+    ulib::json object;
+    std::vector<std::string> names;
+    for (int64_t i = 0; i < state.range(0); i++)
+    {
+        names.push_back("key_" + std::to_string(i));
+        object[names.back()] = i;
+    }
+
+    for (auto _ : state)
+    {
+        for (auto &name : names)
+            benchmark::DoNotOptimize(object.find(name));
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations() * names.size()));
+}
+
+BENCHMARK(BM_ParseNested)->Arg(16)->Arg(256)->Arg(1000);
+BENCHMARK(BM_ParseRecords)->Arg(100)->Arg(10000);
+BENCHMARK(BM_ParseRecordsReuse)->Arg(100)->Arg(10000);
+BENCHMARK(BM_ParseRecordsGet)->Arg(100)->Arg(10000);
+BENCHMARK(BM_ParseRecordsInto)->Arg(100)->Arg(10000);
+BENCHMARK(BM_SelectRecords)->Arg(100)->Arg(10000);
+BENCHMARK(BM_SkipRecords)->Arg(100)->Arg(10000);
+BENCHMARK(BM_ParseRecordsParallel)->Args({200000, 1})->Args({200000, 2})->Args({200000, 4})->Args({200000, 8})->UseRealTime();
+BENCHMARK(BM_FindKeys)->Arg(16)->Arg(64)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_ParseNumbers)->Arg(1000)->Arg(1000000);
+BENCHMARK(BM_ParseShortStrings)->Arg(1000)->Arg(1000000);
+BENCHMARK(BM_SumNumbers)->Arg(1000)->Arg(1000000)->Arg(10000000);
+BENCHMARK(BM_ParseNumbersLazy)->Arg(1000)->Arg(1000000);
+BENCHMARK(BM_RoundTripNumbers)->Args({1000000, 0})->Args({1000000, 1});
+BENCHMARK(BM_ParseRecordsTape)->Arg(100)->Arg(10000);
+BENCHMARK(BM_ParseRecordsTapeGet)->Arg(100)->Arg(10000);
+BENCHMARK(BM_SumNumbersTape)->Arg(1000)->Arg(1000000)->Arg(10000000);
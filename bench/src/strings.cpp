@@ -0,0 +1,67 @@
+#include <benchmark/benchmark.h>
+#include <ulib/json.h>
+#include <ulib/json_simd.h>
+
+#include <string>
+
+// string heavy documents: ascii text, multilingual text, text with \u escapes
+static std::string strings_document(int kind, size_t count)
+{
+    const char *samples[] = {
+        "The quick brown fox jumps over the lazy dog, again and again",
+        "Съешь же ещё этих мягких французских булок, да выпей чаю 東京 😀",
+        "caf\\u00e9 \\u20ac \\ud83d\\ude00 and some plain words around them",
+    };
+
+    std::string str = "[";
+    for (size_t i = 0; i != count; i++)
+    {
+        if (i)
+            str += ",";
+
+        str += R"({"text":")" + std::string(samples[kind]) + R"(","id":)" + std::to_string(i) + "}";
+    }
+
+    str += "]";
+    return str;
+}
+
+static void BM_ParseStrings(benchmark::State &state, ulib::json::string_validation validation)
+{
+    std::string str = strings_document(int(state.range(0)), 10000);
+
+    ulib::json::parse_options options;
+    options.strings = validation;
+    options.reuse_storage = true;
+
+    ulib::json::parser parser{options};
+    ulib::json value;
+    for (auto _ : state)
+    {
+        parser.parse(str, value);
+        benchmark::DoNotOptimize(value);
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations() * str.size()));
+}
+
+// the validator alone over multilingual text
+static void BM_FindInvalidUtf8(benchmark::State &state)
+{
+    std::string str;
+    while (str.size() < 1024 * 1024)
+        str += "Съешь же ещё этих мягких французских булок, да выпей чаю 東京 😀 ";
+
+    for (auto _ : state)
+    {
+        const char *end = ulib::json_detail::find_invalid_utf8(str.data(), str.data() + str.size());
+        benchmark::DoNotOptimize(end);
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations() * str.size()));
+}
+
+// 0: ascii, 1: multilingual, 2: \u escapes
+BENCHMARK_CAPTURE(BM_ParseStrings, strict, ulib::json::string_validation::strict)->DenseRange(0, 2);
+BENCHMARK_CAPTURE(BM_ParseStrings, trusted, ulib::json::string_validation::trusted)->DenseRange(0, 2);
+BENCHMARK(BM_FindInvalidUtf8);
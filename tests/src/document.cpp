@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <ulib/json.h>
+
+#include <fstream>
+
+TEST(Document, ParseAndRead)
+{
+    ulib::json::document doc;
+    doc.parse(R"({"name": "document", "values": [1, 2.5, "three", {"four": [4]}], "flag": true})");
+
+    const auto &root = doc.mutable_root();
+    ASSERT_TRUE(root.is_object());
+    ASSERT_EQ(root["name"].get<std::string>(), "document");
+    ASSERT_EQ(root["values"].size(), 4);
+    ASSERT_EQ(root["values"][0].get<int>(), 1);
+    ASSERT_EQ(root["values"][2].get<std::string>(), "three");
+    ASSERT_EQ(root["values"][3]["four"][0].get<int>(), 4);
+    ASSERT_EQ(doc["flag"].get<bool>(), true);
+    ASSERT_GT(doc.capacity(), 0);
+
+    ASSERT_EQ(root.dump(), R"({"name":"document","values":[1,2.5,"three",{"four":[4]}],"flag":true})");
+}
+
+TEST(Document, Modify)
+{
+    ulib::json::document doc;
+    doc.parse(R"({"list": [1, 2, 3]})");
+
+    auto &root = doc.mutable_root();
+    for (int i = 0; i < 100; i++)
+        root["list"].push_back() = i;
+    root["text"] = "added after parsing";
+    root.remove("list");
+
+    ASSERT_EQ(root.dump(), R"({"text":"added after parsing"})");
+}
+
+TEST(Document, CopyOutlivesDocument)
+{
+    ulib::json copy;
+
+    {
+        ulib::json::document doc;
+        doc.parse(R"({"nested": {"key": "value"}})");
+        copy = doc["nested"];
+    }
+
+    ASSERT_EQ(copy["key"].get<std::string>(), "value");
+}
+
+TEST(Document, ReparseAndMove)
+{
+    ulib::json::document doc;
+    doc.parse(R"([1, 2, 3])");
+    doc.parse(R"(["a", "b"])");
+    ASSERT_EQ(doc.root().size(), 2);
+
+    ASSERT_ANY_THROW(doc.parse(R"(["a", )"));
+    ASSERT_TRUE(doc.root().is_null());
+
+    doc.parse(R"({"k": "v"})");
+    ulib::json::document other = std::move(doc);
+    ASSERT_EQ(other["k"].get<std::string>(), "v");
+}
+
+TEST(Document, ParseFileInSitu)
+{
+    auto path = std::filesystem::temp_directory_path() / "ulib_json_document_file.json";
+    {
+        std::ofstream out{path, std::ios::binary};
+        out << R"({"name": "mapped", "escaped": "a\tb", "list": [1, 2, 3]})";
+    }
+
+    ulib::json::parse_options options;
+    options.in_situ = true;
+
+    ulib::json::document doc;
+    doc.parse_file(path, options);
+    ASSERT_EQ(doc["name"].get<std::string>(), "mapped");
+    ASSERT_EQ(doc["escaped"].get<std::string>(), "a\tb");
+    ASSERT_EQ(doc["list"][2].get<int>(), 3);
+
+    ulib::json::document moved = std::move(doc);
+    ASSERT_EQ(moved["name"].get<std::string>(), "mapped");
+
+    moved.parse("[]");
+    ASSERT_EQ(moved.root().size(), 0);
+
+    std::filesystem::remove(path);
+}
@@ -1,5 +1,46 @@
 #include <gtest/gtest.h>
 #include <ulib/json.h>
+#include <ulib/json_struct.h>
+
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+namespace
+{
+    struct address
+    {
+        std::string city;
+        std::optional<int> zip;
+    };
+
+    ULIB_JSON_STRUCT(address, city, zip)
+
+    struct user
+    {
+        int64_t id = 0;
+        ulib::string name;
+        bool active = false;
+        double score = 0;
+        std::vector<address> addresses;
+        std::optional<std::vector<std::string>> tags;
+        ulib::json extra;
+    };
+
+    ULIB_JSON_STRUCT(user, id, name, active, score, addresses, tags, extra)
+
+    // keys named apart from the members, two of them alike in length, first, middle and last character
+    struct renamed
+    {
+        int a = 0;
+        int b = 0;
+    };
+
+    constexpr auto ulib_json_fields(const renamed *)
+    {
+        return std::make_tuple(ulib::json_field("key_a1_x", &renamed::a), ulib::json_field("key_b1_x", &renamed::b));
+    }
+} // namespace
 
 TEST(Tree, CanParseString)
 {
@@ -222,4 +263,1130 @@ TEST(Tree, ParseNull)
 {
     auto value = ulib::json::parse(R"(null)");
     ASSERT_TRUE(value.is_null());
-}
\ No newline at end of file
+}
+TEST(Tree, ParseStringsWithStructuralCharacters)
+{
+    auto value = ulib::json::parse(R"({"a{b": "[1, 2]", "c\"d": "e\\", "f": ":,}"})");
+
+    ASSERT_TRUE(value.is_object());
+    ASSERT_EQ(value.items().size(), 3);
+    ASSERT_EQ(value["a{b"].get<std::string>(), "[1, 2]");
+    ASSERT_EQ(value["c\"d"].get<std::string>(), "e\\");
+    ASSERT_EQ(value["f"].get<std::string>(), ":,}");
+}
+
+TEST(Tree, ParseLargeArray)
+{
+    // spans several stage 1 windows
+    std::string str = "[";
+    for (int i = 0; i < 20000; i++)
+    {
+        if (i)
+            str += ", ";
+        str += std::to_string(i) + ", \"s" + std::to_string(i) + "\\\"\"";
+    }
+    str += "]";
+
+    auto value = ulib::json::parse(str);
+
+    ASSERT_TRUE(value.is_array());
+    ASSERT_EQ(value.size(), 40000);
+    for (int i = 0; i < 20000; i++)
+    {
+        ASSERT_EQ(value[i * 2].get<int>(), i);
+        ASSERT_EQ(value[i * 2 + 1].get<std::string>(), "s" + std::to_string(i) + "\"");
+    }
+}
+
+TEST(Tree, ParseInvalidThrows)
+{
+    ASSERT_ANY_THROW(ulib::json::parse(""));
+    ASSERT_ANY_THROW(ulib::json::parse("   "));
+    ASSERT_ANY_THROW(ulib::json::parse("[1, 2"));
+    ASSERT_ANY_THROW(ulib::json::parse("[1 2]"));
+    ASSERT_ANY_THROW(ulib::json::parse(R"({"a" 1})"));
+    ASSERT_ANY_THROW(ulib::json::parse(R"({"a": 1,})"));
+    ASSERT_ANY_THROW(ulib::json::parse("[12a]"));
+    ASSERT_ANY_THROW(ulib::json::parse("[tru]"));
+    ASSERT_ANY_THROW(ulib::json::parse("nul"));
+    ASSERT_ANY_THROW(ulib::json::parse(R"("abc)"));
+}
+
+TEST(Tree, ParseDuplicateKeys)
+{
+    auto str = R"({"a": 1, "b": 2, "a": 3})";
+
+    {
+        auto value = ulib::json::parse(str);
+        ASSERT_EQ(value.items().size(), 2);
+        ASSERT_EQ(value.items()[0].name(), "a");
+        ASSERT_EQ(value["a"].get<int>(), 3);
+        ASSERT_EQ(value["b"].get<int>(), 2);
+    }
+
+    {
+        auto value = ulib::json::parse(str, {ulib::json::duplicate_keys::first_wins});
+        ASSERT_EQ(value.items().size(), 2);
+        ASSERT_EQ(value["a"].get<int>(), 1);
+    }
+
+    {
+        auto value = ulib::json::parse(str, {ulib::json::duplicate_keys::keep_all});
+        ASSERT_EQ(value.items().size(), 3);
+        ASSERT_EQ(value.items()[2].name(), "a");
+        ASSERT_EQ(value.items()[2].value().get<int>(), 3);
+    }
+
+    ASSERT_ANY_THROW(ulib::json::parse(str, {ulib::json::duplicate_keys::reject}));
+    ASSERT_NO_THROW(ulib::json::parse(R"({"a": 1, "b": 2})", {ulib::json::duplicate_keys::reject}));
+}
+
+TEST(Tree, ParseLargeObject)
+{
+    std::string str = "{";
+    for (int i = 0; i < 50000; i++)
+        str += "\"key" + std::to_string(i) + "\": " + std::to_string(i) + ", ";
+    str += "\"key7\": -7}";
+
+    auto value = ulib::json::parse(str);
+    ASSERT_EQ(value.items().size(), 50000);
+    ASSERT_EQ(value.items()[49999].name(), "key49999");
+    ASSERT_EQ(value.at("key7").get<int>(), -7);
+    ASSERT_EQ(value.at("key49999").get<int>(), 49999);
+
+    ASSERT_ANY_THROW(ulib::json::parse(str, {ulib::json::duplicate_keys::reject}));
+}
+
+TEST(Tree, ParseEscapedStrings)
+{
+    auto value = ulib::json::parse(R"(["\\", "\"", "a\nb", "tab\tand\\slash", "\/", "x\"y\\z"])");
+
+    ASSERT_EQ(value[0].get<std::string>(), "\\");
+    ASSERT_EQ(value[1].get<std::string>(), "\"");
+    ASSERT_EQ(value[2].get<std::string>(), "a\nb");
+    ASSERT_EQ(value[3].get<std::string>(), "tab\tand\\slash");
+    ASSERT_EQ(value[4].get<std::string>(), "/");
+    ASSERT_EQ(value[5].get<std::string>(), "x\"y\\z");
+
+    std::string longText;
+    for (int i = 0; i < 300; i++)
+        longText += (i % 37 == 0) ? "\\n" : (i % 53 == 0) ? "\\\"" : "text ";
+
+    std::string expected;
+    for (int i = 0; i < 300; i++)
+        expected += (i % 37 == 0) ? "\n" : (i % 53 == 0) ? "\"" : "text ";
+
+    ASSERT_EQ(ulib::json::parse("\"" + longText + "\"").get<std::string>(), expected);
+    ASSERT_ANY_THROW(ulib::json::parse(R"("abc\)"));
+    ASSERT_ANY_THROW(ulib::json::parse(R"("abc\")"));
+}
+
+TEST(Tree, ParseNumbers)
+{
+    auto value = ulib::json::parse(
+        R"([1e10, -2.5E-3, 0.1, 1.7976931348623157e308, 9007199254740993, -9223372036854775808,
+            18446744073709551615, 18446744073709551616, 123456789.123456789, 0, -0.0])");
+
+    ASSERT_TRUE(value[0].is_float());
+    ASSERT_EQ(value[0].get<double>(), 1e10);
+    ASSERT_EQ(value[1].get<double>(), -2.5e-3);
+    ASSERT_EQ(value[2].get<double>(), 0.1);
+    ASSERT_EQ(value[3].get<double>(), 1.7976931348623157e308);
+
+    ASSERT_TRUE(value[4].is_int());
+    ASSERT_EQ(value[4].get<int64_t>(), 9007199254740993);
+    ASSERT_EQ(value[5].get<int64_t>(), INT64_MIN);
+
+    ASSERT_EQ(value[6].type(), ulib::json::value_t::unsigned_integer);
+    ASSERT_EQ(value[6].get<uint64_t>(), UINT64_MAX);
+
+    ASSERT_TRUE(value[7].is_float());
+    ASSERT_EQ(value[7].get<double>(), 18446744073709551616.0);
+    ASSERT_EQ(value[8].get<double>(), 123456789.123456789);
+    ASSERT_TRUE(value[9].is_int());
+    ASSERT_TRUE(value[10].is_float());
+
+    ASSERT_ANY_THROW(ulib::json::parse("01"));
+    ASSERT_ANY_THROW(ulib::json::parse("1."));
+    ASSERT_ANY_THROW(ulib::json::parse("-"));
+    ASSERT_ANY_THROW(ulib::json::parse("1e"));
+    ASSERT_ANY_THROW(ulib::json::parse("[.5]"));
+}
+
+TEST(Tree, ParseInSitu)
+{
+    std::string str = R"({"name": "plain", "escaped": "a\nb", "list": ["x", "y"]})";
+
+    ulib::json::parse_options options;
+    options.in_situ = true;
+    auto value = ulib::json::parse(str, options);
+
+    auto name = value.at("name").get<ulib::string_view>();
+    ASSERT_EQ(name, "plain");
+    ASSERT_TRUE(name.data() >= str.data() && name.data() < str.data() + str.size());
+    ASSERT_TRUE(value.items()[0].name().data() >= str.data() &&
+                value.items()[0].name().data() < str.data() + str.size());
+
+    auto escaped = value.at("escaped").get<ulib::string_view>();
+    ASSERT_EQ(escaped, "a\nb");
+    ASSERT_FALSE(escaped.data() >= str.data() && escaped.data() < str.data() + str.size());
+
+    value.at("list")[0] = "z";
+    ASSERT_EQ(value.at("list")[0].get<std::string>(), "z");
+
+    ulib::json copy = value;
+    str.assign(str.size(), ' ');
+
+    ASSERT_EQ(copy.at("name").get<std::string>(), "plain");
+    ASSERT_EQ(copy.items()[2].name(), "list");
+    ASSERT_EQ(copy.at("list")[1].get<std::string>(), "y");
+}
+
+TEST(Tree, PushParserChunks)
+{
+    std::string str = R"({"name": "chunked \"value\"", "list": [1, -2.5e3, true, false, null, []],
+                          "nested": {"k": {}, "big": 18446744073709551615}, "name": "last"})";
+    std::string expected = ulib::json::parse(str).dump();
+
+    for (size_t chunk : {size_t(1), size_t(3), size_t(7), str.size()})
+    {
+        ulib::json::push_parser parser;
+        for (size_t i = 0; i < str.size(); i += chunk)
+        {
+            bool done = parser.feed(ulib::string_view{str.data() + i, std::min(chunk, str.size() - i)});
+            ASSERT_EQ(done, i + chunk >= str.size());
+        }
+
+        parser.finish();
+        ASSERT_EQ(parser.take().dump(), expected);
+        ASSERT_FALSE(parser.done());
+    }
+}
+
+TEST(Tree, PushParserScalarsAndErrors)
+{
+    ulib::json::push_parser parser;
+    ASSERT_FALSE(parser.feed("12"));
+    ASSERT_TRUE(parser.feed("34 "));
+    ASSERT_EQ(parser.take().get<int>(), 1234);
+
+    ASSERT_FALSE(parser.feed("-0.5"));
+    parser.finish();
+    ASSERT_EQ(parser.take().get<double>(), -0.5);
+
+    ASSERT_FALSE(parser.feed("[1, 2"));
+    ASSERT_ANY_THROW(parser.finish());
+    parser.reset();
+
+    ASSERT_ANY_THROW(parser.feed("[1, 2}"));
+    parser.reset();
+    ASSERT_ANY_THROW(parser.feed("{\"a\" 1}"));
+    parser.reset();
+    ASSERT_ANY_THROW(parser.feed("tru "));
+    parser.reset();
+    ASSERT_ANY_THROW(parser.feed("{} {}"));
+    parser.reset();
+
+    ulib::json::parse_options options;
+    options.duplicates = ulib::json::duplicate_keys::reject;
+    ulib::json::push_parser strict{options};
+    ASSERT_ANY_THROW(strict.feed(R"({"a": 1, "a": 2})"));
+}
+
+namespace
+{
+    struct EventRecorder
+    {
+        std::string events;
+        std::string stopAtKey;
+
+        bool start_object() { return events += "{", true; }
+        bool end_object() { return events += "}", true; }
+        bool start_array() { return events += "[", true; }
+        bool end_array() { return events += "]", true; }
+        bool key(ulib::string_view name)
+        {
+            events += "k:" + std::string(name.data(), name.size()) + " ";
+            return name != stopAtKey.c_str();
+        }
+        bool string(ulib::string_view str) { return events += "s:" + std::string(str.data(), str.size()) + " ", true; }
+        bool integer(int64_t v) { return events += "i:" + std::to_string(v) + " ", true; }
+        bool unsigned_integer(uint64_t v) { return events += "u:" + std::to_string(v) + " ", true; }
+        bool floating(double v) { return events += "d:" + std::to_string(v) + " ", true; }
+        bool boolean(bool v) { return events += v ? "true " : "false ", true; }
+        bool null() { return events += "null ", true; }
+    };
+} // namespace
+
+TEST(Tree, SaxEvents)
+{
+    std::string str = R"({"a": [1, -2, 2.5, 18446744073709551615], "b\n": "x\"y", "c": {"d": [true, false, null]}})";
+
+    EventRecorder recorder;
+    ulib::json::parser parser;
+    ASSERT_TRUE(parser.sax_parse(str, recorder));
+    ASSERT_EQ(recorder.events, "{k:a [i:1 i:-2 d:2.500000 u:18446744073709551615 ]k:b\n s:x\"y "
+                               "k:c {k:d [true false null ]}}");
+
+    EventRecorder stopping;
+    stopping.stopAtKey = "c";
+    ASSERT_FALSE(parser.sax_parse(str, stopping));
+    ASSERT_EQ(stopping.events.find("k:d"), std::string::npos);
+
+    EventRecorder invalid;
+    ASSERT_ANY_THROW(parser.sax_parse(R"({"a": [1, 2})", invalid));
+}
+
+TEST(Tree, LazyDocument)
+{
+    std::string str = R"({"skip": [1, {"a": [[]]}, "]"], "user": {"name": "bob", "id": 42, "tags": ["x", "y\"z"]},
+                          "ratio": 0.5, "big": 18446744073709551615, "esc\"key": null, "flag": true})";
+
+    auto doc = ulib::json::parse_lazy(str);
+    ASSERT_EQ(doc["user"]["id"].get<int64_t>(), 42);
+    ASSERT_EQ(doc["user"]["tags"][1].get<std::string>(), "y\"z");
+    ASSERT_EQ(doc["ratio"].get<double>(), 0.5);
+    ASSERT_EQ(doc["big"].type(), ulib::json::value_t::unsigned_integer);
+    ASSERT_EQ(doc["esc\"key"].type(), ulib::json::value_t::null);
+    ASSERT_TRUE(doc["flag"].get<bool>());
+    ASSERT_EQ(doc["skip"][2].get<std::string>(), "]");
+
+    // random order: seeks back into the already indexed input
+    auto user = doc["user"];
+    ASSERT_EQ(doc["flag"].type(), ulib::json::value_t::boolean);
+    auto name = user["name"].get<ulib::string_view>();
+    ASSERT_EQ(name, "bob");
+    ASSERT_TRUE(name.data() > str.data() && name.data() < str.data() + str.size());
+
+    ASSERT_EQ(user.value().dump(), ulib::json::parse(str)["user"].dump());
+
+    ASSERT_FALSE(doc.root().find("missing").has_value());
+    ASSERT_ANY_THROW(doc["missing"]);
+    ASSERT_ANY_THROW(doc["user"][0]);
+    ASSERT_ANY_THROW(doc["skip"][3]);
+}
+
+TEST(Tree, LazyDocumentAcrossWindows)
+{
+    std::string str = "[";
+    for (int i = 0; i < 20000; i++)
+        str += "{\"id\": " + std::to_string(i) + ", \"name\": \"item" + std::to_string(i) + "\"}, ";
+    str += "{\"id\": -1}]";
+
+    auto doc = ulib::json::parse_lazy(str);
+    ASSERT_EQ(doc[19999]["name"].get<std::string>(), "item19999");
+    ASSERT_EQ(doc[5]["id"].get<int>(), 5);
+    ASSERT_EQ(doc[20000]["id"].get<int>(), -1);
+    ASSERT_EQ(doc[12345]["id"].get<int>(), 12345);
+}
+
+TEST(Tree, NdjsonReader)
+{
+    std::string str;
+    for (int i = 0; i < 30000; i++)
+    {
+        str += "{\"id\": " + std::to_string(i) + ", \"name\": \"n" + std::to_string(i) + "\"}\n";
+        if (i % 1000 == 0)
+            str += "  \r\n";
+    }
+
+    ulib::json::ndjson_options options;
+    options.threads = 4;
+    options.chunk_size = 4096;
+    ulib::json::ndjson_reader reader{options};
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        int expected = 0;
+        size_t count = reader.read(str, [&](ulib::json &value) {
+            EXPECT_EQ(value["id"].get<int>(), expected);
+            expected++;
+            return true;
+        });
+
+        ASSERT_EQ(count, 30000);
+        ASSERT_EQ(expected, 30000);
+    }
+
+    size_t count = reader.read(str, [](ulib::json &value) { return value["id"].get<int>() < 99; });
+    ASSERT_EQ(count, 100);
+
+    std::string bad = str + "{\"id\": 1} 2\n{\"id\": 2}\n";
+    count = 0;
+    try
+    {
+        reader.read(bad, [&](ulib::json &) { return ++count, true; });
+        FAIL();
+    }
+    catch (const ulib::ParseError &e)
+    {
+        ASSERT_EQ(count, 30000);
+        ASSERT_NE(std::string(e.what()).find("line 30031"), std::string::npos);
+    }
+}
+
+TEST(Tree, ParseFile)
+{
+    auto path = std::filesystem::temp_directory_path() / "ulib_json_parse_file.json";
+    {
+        std::ofstream out{path, std::ios::binary};
+        out << "{\"values\": [";
+        for (int i = 0; i < 10000; i++)
+            out << i << ", ";
+        out << "-1]}";
+    }
+
+    ulib::json::parse_options options;
+    options.in_situ = true;
+    auto value = ulib::json::parse_file(path, options);
+    ASSERT_EQ(value["values"].size(), 10001);
+    ASSERT_EQ(value["values"][9999].get<int>(), 9999);
+    ASSERT_EQ(value.items()[0].name(), "values");
+
+    {
+        std::ofstream out{path, std::ios::binary};
+        out << "{\n  \"a\": [1,\n  2 x]}";
+    }
+
+    try
+    {
+        ulib::json::parse_file(path);
+        FAIL();
+    }
+    catch (const ulib::ParseError &e)
+    {
+        ASSERT_NE(std::string(e.what()).find("at 3:"), std::string::npos);
+    }
+
+    {
+        std::ofstream out{path, std::ios::binary};
+    }
+    ASSERT_ANY_THROW(ulib::json::parse_file(path));
+
+    std::filesystem::remove(path);
+    ASSERT_ANY_THROW(ulib::json::parse_file(path));
+}
+
+TEST(Tree, TryParse)
+{
+    ulib::json::parser parser;
+    ulib::json value;
+
+    auto status = parser.try_parse(R"({"a": [1, 2]})", value);
+    ASSERT_TRUE(status);
+    ASSERT_EQ(value["a"][1].get<int>(), 2);
+
+    std::string str = "{\n  \"a\": [1,\n  2 x]}";
+    status = parser.try_parse(str, value);
+    ASSERT_FALSE(status);
+    ASSERT_EQ(status.error, ulib::json::errc::unexpected_character);
+    ASSERT_EQ(status.offset, str.find('x'));
+    ASSERT_TRUE(parser.error_message() == "Unexpected character at 3:4");
+
+    ASSERT_EQ(parser.try_parse("[1, 2", value).error, ulib::json::errc::unexpected_end);
+    ASSERT_EQ(parser.try_parse("[1, 0x2]", value).error, ulib::json::errc::unexpected_character);
+    ASSERT_EQ(parser.try_parse("[1, -]", value).error, ulib::json::errc::invalid_number);
+    ASSERT_EQ(parser.try_parse("[nul]", value).error, ulib::json::errc::invalid_literal);
+    ASSERT_EQ(parser.try_parse("[1, ?]", value).error, ulib::json::errc::invalid_value);
+
+    ulib::json::parser strict{{ulib::json::duplicate_keys::reject}};
+    status = strict.try_parse(R"({"a": 1, "a": 2})", value);
+    ASSERT_EQ(status.error, ulib::json::errc::duplicate_key);
+    ASSERT_EQ(status.offset, 15);
+
+    try
+    {
+        parser.parse(str);
+        FAIL();
+    }
+    catch (const ulib::ParseError &e)
+    {
+        ASSERT_TRUE(std::string(e.what()) == "Unexpected character at 3:4");
+    }
+
+    // a trimmed parser grows its buffers again on the next large document
+    std::string escaped = "[\"" + std::string(100000, 'a') + "\\n\"]";
+    ASSERT_EQ(parser.parse(escaped)[0].get<ulib::string_view>().size(), 100001);
+    parser.trim_buffers();
+    ASSERT_EQ(parser.parse(escaped)[0].get<ulib::string_view>().size(), 100001);
+}
+
+TEST(Tree, DepthLimit)
+{
+    std::string deep = std::string(100000, '[') + std::string(100000, ']');
+
+    ulib::json::parser parser;
+    ulib::json value;
+    auto status = parser.try_parse(deep, value);
+    ASSERT_EQ(status.error, ulib::json::errc::depth_exceeded);
+    ASSERT_EQ(status.offset, 1024);
+    ASSERT_THROW(ulib::json::parse(deep), ulib::ParseError);
+
+    ulib::json::parse_options options;
+    options.max_depth = 5000;
+    value = ulib::json::parse(std::string(5000, '[') + std::string(5000, ']'), options);
+    const ulib::json *it = &value;
+    for (size_t i = 0; i != 4999; i++)
+        it = &(*it)[0];
+    ASSERT_TRUE(it->is_array() && it->size() == 0);
+
+    std::string nested = R"({"a": [{"b": []}, {}, [[1, "x"]]], "c": {"d": {"e": null}}})";
+    options.max_depth = 4;
+    ASSERT_EQ(ulib::json::parse(nested, options).dump(), ulib::json::parse(nested).dump());
+
+    options.max_depth = 3;
+    ulib::json::parser limited{options};
+    ASSERT_EQ(limited.try_parse(nested, value).error, ulib::json::errc::depth_exceeded);
+
+    struct Counter
+    {
+        bool start_object() { return true; }
+        bool end_object() { return true; }
+        bool start_array() { return true; }
+        bool end_array() { return true; }
+        bool key(ulib::string_view) { return true; }
+        bool string(ulib::string_view) { return true; }
+        bool integer(int64_t) { return true; }
+        bool unsigned_integer(uint64_t) { return true; }
+        bool floating(double) { return true; }
+        bool boolean(bool) { return true; }
+        bool null() { return true; }
+    } counter;
+    ASSERT_THROW(limited.sax_parse(nested, counter), ulib::ParseError);
+
+    ulib::json::push_parser push{options};
+    ASSERT_THROW(push.feed(nested), ulib::ParseError);
+}
+
+TEST(Tree, ParseReuseStorage)
+{
+    ulib::json::parse_options options;
+    options.reuse_storage = true;
+    ulib::json::parser parser{options};
+
+    ulib::json value;
+    parser.parse(R"({"name": "first message of the session", "ids": [1, 2, 3], "meta": {"ok": true, "tag": "abc"}})", value);
+
+    const char *name = value["name"].get<ulib::string_view>().data();
+    const ulib::json *ids = value["ids"].values().data();
+    const ulib::json *meta = value["meta"].items().data();
+
+    std::string next = R"({"name": "second", "ids": [4, 5], "meta": {"ok": false, "tag": "xyz"}})";
+    parser.parse(next, value);
+    ASSERT_EQ(value.dump(), ulib::json::parse(next).dump());
+    ASSERT_EQ(value["name"].get<ulib::string_view>().data(), name);
+    ASSERT_EQ(value["ids"].values().data(), ids);
+    ASSERT_EQ(value["meta"].items().data(), meta);
+
+    // another shape replaces what doesn't fit
+    next = R"({"ids": {"x": null}, "name": 5, "extra": ["a", [true]], "ids": 1.5})";
+    parser.parse(next, value);
+    ASSERT_EQ(value.dump(), ulib::json::parse(next).dump());
+
+    parser.parse("[null]", value);
+    ASSERT_EQ(value.dump(), "[null]");
+
+    // without reuse_storage out is replaced whatever it held
+    ulib::json::parser plain;
+    plain.parse("7", value);
+    ASSERT_EQ(value.get<int>(), 7);
+}
+
+TEST(Tree, ParseUnicodeStrings)
+{
+    std::string str = R"(["\u00e9", "\u20AC", "\uD83D\uDE00", "caf\u00e9\u0020\u0041", "ключ \u20ac"])";
+    auto value = ulib::json::parse(str);
+    ASSERT_EQ(value[0].get<std::string>(), "\xC3\xA9");
+    ASSERT_EQ(value[1].get<std::string>(), "\xE2\x82\xAC");
+    ASSERT_EQ(value[2].get<std::string>(), "\xF0\x9F\x98\x80");
+    ASSERT_EQ(value[3].get<std::string>(), "caf\xC3\xA9 A");
+    ASSERT_EQ(value[4].get<std::string>(), "ключ €");
+
+    ulib::json::push_parser push;
+    for (char ch : str)
+        push.feed(ulib::string_view{&ch, 1});
+    ASSERT_EQ(push.take().dump(), value.dump());
+
+    ulib::json::parser strict;
+    ulib::json out;
+    std::string bad = "[\"ok\", \"abc\xC3\x28\"]";
+    auto status = strict.try_parse(bad, out);
+    ASSERT_EQ(status.error, ulib::json::errc::invalid_utf8);
+    ASSERT_EQ(status.offset, bad.find('\xC3'));
+
+    ASSERT_EQ(strict.try_parse("{\"\xC0\xAF\": 1}", out).error, ulib::json::errc::invalid_utf8);
+    ASSERT_EQ(strict.try_parse("[\"\xED\xA0\x80\"]", out).error, ulib::json::errc::invalid_utf8);
+    ASSERT_EQ(strict.try_parse(R"(["\uD800"])", out).error, ulib::json::errc::invalid_escape);
+    ASSERT_EQ(strict.try_parse(R"(["\uDC00\uD800"])", out).error, ulib::json::errc::invalid_escape);
+    ASSERT_EQ(strict.try_parse(R"(["\u12G4"])", out).error, ulib::json::errc::invalid_escape);
+    ASSERT_EQ(strict.try_parse(R"(["\q"])", out).error, ulib::json::errc::invalid_escape);
+    ASSERT_THROW(ulib::json::push_parser{}.feed("[\"abc\xC3\x28\"]"), ulib::ParseError);
+    ASSERT_THROW(ulib::json::push_parser{}.feed(R"(["\uD800x"])"), ulib::ParseError);
+
+    ulib::json::parse_options options;
+    options.strings = ulib::json::string_validation::trusted;
+    value = ulib::json::parse(R"(["\uD800x", "\q", "\ud83d\ude00"])", options);
+    ASSERT_EQ(value[0].get<std::string>(), "\xEF\xBF\xBDx");
+    ASSERT_EQ(value[1].get<std::string>(), "q");
+    ASSERT_EQ(value[2].get<std::string>(), "\xF0\x9F\x98\x80");
+
+    ulib::json::push_parser trusted{options};
+    trusted.feed(R"(["\uD800x", "\q"])");
+    ASSERT_EQ(trusted.take().dump(), ulib::json::parse(R"(["\uD800x", "\q"])", options).dump());
+}
+
+TEST(Tree, KeyPool)
+{
+    ulib::json::key_pool keys;
+    ASSERT_EQ(keys.intern("id").data(), keys.intern(std::string{"id"}).data());
+    ASSERT_FALSE(keys.find("missing"));
+    ASSERT_EQ(keys.size(), 1);
+
+    ulib::json::parse_options options;
+    options.keys = &keys;
+    auto first = ulib::json::parse(R"({"id": 1, "name": "a", "": 0})", options);
+    auto second = ulib::json::parse(R"({"name": "b", "id": 2})", options);
+    ASSERT_EQ(first.items()[0].name().data(), second.items()[1].name().data());
+    ASSERT_EQ(first.items()[1].name().data(), second.items()[0].name().data());
+    ASSERT_EQ(first["name"].get<std::string>(), "a");
+    ASSERT_EQ(second.find("id")->get<int>(), 2);
+    ASSERT_EQ(first[""].get<int>(), 0);
+    ASSERT_FALSE(second.find("missing"));
+
+    // pooled and owned keys in one object, copies keep pointing into the pool
+    second["extra"] = 3;
+    ulib::json copy = second;
+    ASSERT_EQ(copy.items()[0].name().data(), first.items()[1].name().data());
+    ASSERT_EQ(copy["extra"].get<int>(), 3);
+    ASSERT_EQ(copy["id"].get<int>(), 2);
+
+    ulib::json::push_parser push{options};
+    push.feed(R"({"id": 5})");
+    ASSERT_EQ(push.take().items()[0].name().data(), first.items()[0].name().data());
+
+    {
+        ulib::json::key_pool::scope scope{&keys};
+        ulib::json built;
+        built["id"] = 7;
+        ASSERT_EQ(built.items()[0].name().data(), first.items()[0].name().data());
+    }
+
+    ulib::json::key_pool shared;
+    std::string str;
+    for (int i = 0; i < 5000; i++)
+        str += "{\"id\": " + std::to_string(i) + ", \"k" + std::to_string(i % 300) + "\": true}\n";
+
+    ulib::json::ndjson_options ndjson;
+    ndjson.threads = 4;
+    ndjson.chunk_size = 1024;
+    ndjson.parse.keys = &shared;
+    ulib::json::ndjson_reader reader{ndjson};
+
+    const char *id = nullptr;
+    reader.read(str, [&](ulib::json &value) {
+        if (!id)
+            id = value.items()[0].name().data();
+        EXPECT_EQ(value.items()[0].name().data(), id);
+        return true;
+    });
+
+    ASSERT_EQ(shared.size(), 301);
+    ASSERT_EQ(shared.find("k299")->data(), shared.intern("k299").data());
+}
+
+TEST(Tree, ParseIntoStruct)
+{
+    std::string str = R"({"id": 42, "unknown": {"a": [1, 2]}, "name": "caf\u00e9", "active": true,
+        "score": 2, "addresses": [{"city": "Oslo", "zip": 150}, {"city": "Rome", "zip": null}],
+        "tags": ["a", "b"], "extra": {"any": [null]}})";
+
+    ulib::json::parser prsr;
+    user out;
+    prsr.parse_into(str, out);
+    ASSERT_EQ(out.id, 42);
+    ASSERT_EQ(out.name, "caf\xC3\xA9");
+    ASSERT_TRUE(out.active);
+    ASSERT_EQ(out.score, 2.0);
+    ASSERT_EQ(out.addresses.size(), 2);
+    ASSERT_EQ(out.addresses[0].city, "Oslo");
+    ASSERT_EQ(out.addresses[0].zip, 150);
+    ASSERT_FALSE(out.addresses[1].zip);
+    ASSERT_EQ(*out.tags, (std::vector<std::string>{"a", "b"}));
+    ASSERT_EQ(out.extra.dump(), ulib::json::parse(R"({"any": [null]})").dump());
+
+    // missing members keep their values, a repeated key is read again
+    prsr.parse_into(R"({"id": 1, "id": 7, "tags": null})", out);
+    ASSERT_EQ(out.id, 7);
+    ASSERT_EQ(out.name, "caf\xC3\xA9");
+    ASSERT_FALSE(out.tags);
+
+    renamed r;
+    prsr.parse_into(R"({"key_b1_x": 2, "key_a1_x": 1, "a": 5})", r);
+    ASSERT_EQ(r.a, 1);
+    ASSERT_EQ(r.b, 2);
+
+    std::vector<int> numbers;
+    prsr.parse_into("[1, 2, 3]", numbers);
+    ASSERT_EQ(numbers, (std::vector<int>{1, 2, 3}));
+
+    ASSERT_EQ(prsr.try_parse_into(R"({"id": "42"})", out).error, ulib::json::errc::wrong_type);
+    ASSERT_EQ(prsr.try_parse_into(R"({"id": 1, "name": 5})", out).offset, 18);
+    ASSERT_EQ(prsr.try_parse_into(R"({"addresses": {}})", out).error, ulib::json::errc::wrong_type);
+    ASSERT_EQ(prsr.try_parse_into(R"({"id": 1,})", out).error, ulib::json::errc::unexpected_character);
+    ASSERT_EQ(prsr.try_parse_into(R"({"id": 1)", out).error, ulib::json::errc::unexpected_end);
+    ASSERT_THROW(prsr.parse_into(R"({"addresses": [{"city": "\q"}]})", out), ulib::ParseError);
+
+    // integral members take integral numbers in their range only
+    prsr.parse_into(R"({"id": 3.0, "score": 1e300})", out);
+    ASSERT_EQ(out.id, 3);
+    ASSERT_EQ(out.score, 1e300);
+    ASSERT_EQ(prsr.try_parse_into(R"({"id": 1e300})", out).error, ulib::json::errc::wrong_type);
+    ASSERT_EQ(prsr.try_parse_into(R"({"id": 1.5})", out).offset, 7);
+    ASSERT_EQ(prsr.try_parse_into(R"({"id": 9223372036854775808})", out).error, ulib::json::errc::wrong_type);
+    ASSERT_EQ(prsr.try_parse_into(R"({"id": -9223372036854775808})", out).error, ulib::json::errc::ok);
+
+    std::vector<uint8_t> bytes;
+    prsr.parse_into("[0, 255]", bytes);
+    ASSERT_EQ(bytes, (std::vector<uint8_t>{0, 255}));
+    ASSERT_EQ(prsr.try_parse_into("[300]", bytes).error, ulib::json::errc::wrong_type);
+    ASSERT_EQ(prsr.try_parse_into("[-1]", bytes).error, ulib::json::errc::wrong_type);
+    ASSERT_EQ(prsr.try_parse_into("[256.0]", bytes).error, ulib::json::errc::wrong_type);
+}
+
+TEST(Tree, SelectPaths)
+{
+    std::string str = R"({"meta": {"skip": [1, {"id": 0}], "id": 7},
+        "payload": {"items": [{"price": 1.5, "name": "a"}, {"name": "b"}, {"price": 3}]},
+        "a/b": {"~": true}})";
+
+    ulib::json::path_set paths{"/meta/id", "/payload/items/*/price", "/a~1b/~0", "/payload/items/1"};
+    ASSERT_EQ(paths.size(), 4);
+
+    ulib::json::parser prsr;
+    std::vector<std::pair<size_t, std::string>> found;
+    auto collect = [&](size_t index, ulib::json &value) {
+        found.emplace_back(index, value.dump());
+        return true;
+    };
+
+    ASSERT_EQ(prsr.select(str, paths, collect), 5);
+    std::vector<std::pair<size_t, std::string>> expected{{0, ulib::json::parse("7").dump()},
+                                                         {1, ulib::json::parse("1.5").dump()},
+                                                         {3, ulib::json::parse(R"({"name": "b"})").dump()},
+                                                         {1, ulib::json::parse("3").dump()},
+                                                         {2, ulib::json::parse("true").dump()}};
+    ASSERT_EQ(found, expected);
+
+    // a value and pointers below it, the whole document
+    ulib::json::path_set nested{"/payload/items/0", "/payload/items/0/name", ""};
+    found.clear();
+    ASSERT_EQ(prsr.select(str, nested, collect), 3);
+    ASSERT_EQ(found[0].first, 2);
+    ASSERT_EQ(found[0].second, ulib::json::parse(str).dump());
+    ASSERT_EQ(found[1].first, 0);
+    ASSERT_EQ(found[2], (std::pair<size_t, std::string>{1, ulib::json::parse(R"("a")").dump()}));
+
+    size_t count = prsr.select(str, paths, [](size_t, ulib::json &) { return false; });
+    ASSERT_EQ(count, 1);
+
+    ASSERT_THROW(prsr.select(R"({"skip": [1, 2)", paths, collect), ulib::ParseError);
+    ASSERT_THROW(prsr.select(R"({"meta": {"id": tru}})", paths, collect), ulib::ParseError);
+    ASSERT_THROW(paths.add("meta"), ulib::json::exception);
+    ASSERT_THROW(paths.add("/a~2"), ulib::json::exception);
+    ASSERT_EQ(paths.size(), 4);
+}
+
+TEST(Tree, SkipValue)
+{
+    ulib::json::parser prsr;
+    std::string str = R"([{"a": "}]\"{\\", "b": [1, [2, {}]]}, 3])";
+    ASSERT_EQ(prsr.skip(str, 1), str.find(", 3"));
+    ASSERT_EQ(prsr.skip(str), str.size());
+    ASSERT_EQ(prsr.skip(R"(  "x" , 1)"), 6);
+
+    // brackets in strings and escapes across blocks and index windows
+    std::string big = "[";
+    for (int i = 0; i < 3000; i++)
+        big += R"({"s": "[\\\"{\\\\", "v": [)" + std::to_string(i) + R"(, {"x": "]}"}]},)";
+    big += "0] ,7";
+    ASSERT_EQ(prsr.skip(big), big.find(" ,7") + 1);
+
+    // lookups pass over the skipped values
+    std::string wrapped = R"({"big": )" + big.substr(0, big.size() - 3) + R"(, "id": 5})";
+    auto doc = ulib::json::parse_lazy(wrapped);
+    ASSERT_EQ(doc["id"].get<int>(), 5);
+
+    ASSERT_THROW(prsr.skip(R"([1, {"a": "]"})"), ulib::ParseError);
+    ASSERT_THROW(prsr.skip("]"), ulib::ParseError);
+    ASSERT_THROW(prsr.skip("  "), ulib::ParseError);
+}
+
+TEST(Tree, ParseParallel)
+{
+    // brackets, commas and escaped quotes inside strings, elements of very different sizes
+    std::string str = " [";
+    for (int i = 0; i < 60000; i++)
+    {
+        if (i)
+            str += ",";
+
+        if (i % 1000 == 7)
+            str += "[" + std::string(5000, ' ') + "{\"deep\": [[" + std::to_string(i) + "]]}]";
+        else
+            str += R"({"id": )" + std::to_string(i) + R"(, "s": "],[\"{,}\\", "v": [1, {"a": null}]})";
+    }
+    str += "]\n";
+
+    ulib::json::parser prsr;
+    auto expected = ulib::json::parse(str);
+    auto value = prsr.parse_parallel(str, 4);
+    ASSERT_EQ(value.size(), 60000);
+    ASSERT_EQ(value.dump(), expected.dump());
+
+    // small documents and other values are parsed on the calling thread
+    ASSERT_EQ(prsr.parse_parallel("[1, 2]", 4).dump(), ulib::json::parse("[1, 2]").dump());
+    ASSERT_EQ(prsr.parse_parallel(R"({"a": [1]})", 4)["a"][0].get<int>(), 1);
+    ASSERT_EQ(prsr.parse_parallel("[" + std::string(3 * 1024 * 1024, ' ') + "]", 4).size(), 0);
+
+    // the first error in the document is the one reported
+    std::string bad = str;
+    bad[bad.find("\"id\": 40000") + 6] = 'x';
+    bad[bad.find("\"id\": 50000") + 6] = '}';
+    ASSERT_THROW(prsr.parse_parallel(bad, 4), ulib::ParseError);
+    ulib::json out;
+    ASSERT_EQ(prsr.status().offset, ulib::json::parser{}.try_parse(bad, out).offset);
+
+    // positions are counted in the whole document, like parse() reports them
+    bad.insert(bad.find("{\"id\": 10000"), "\n");
+    bad.insert(bad.find("{\"id\": 20000"), "\n");
+    ulib::json::parser single;
+    ASSERT_FALSE(single.try_parse(bad, out));
+    try
+    {
+        prsr.parse_parallel(bad, 4);
+        FAIL();
+    }
+    catch (const ulib::ParseError &e)
+    {
+        ASSERT_EQ(std::string(e.what()), std::string(single.error_message()));
+        ASSERT_NE(std::string(e.what()).find(" at 3:"), std::string::npos);
+    }
+
+    ASSERT_THROW(prsr.parse_parallel(str.substr(0, str.size() - 2), 4), ulib::ParseError);
+    ASSERT_THROW(prsr.parse_parallel(str.substr(0, str.size() - 2) + ",]", 4), ulib::ParseError);
+}
+
+TEST(Tree, ObjectIndex)
+{
+    ulib::json built;
+    for (int i = 0; i < 2000; i++)
+        built["k" + std::to_string(i)] = i;
+
+    ASSERT_EQ(built.items().size(), 2000);
+    ASSERT_EQ(built["k1999"].get<int>(), 1999);
+    ASSERT_EQ(built.at("k0").get<int>(), 0);
+    ASSERT_FALSE(built.find("k2000"));
+    ASSERT_EQ(built.items()[1500].name(), "k1500");
+
+    // positions after the removed item move down
+    built.remove("k10");
+    ASSERT_FALSE(built.find("k10"));
+    ASSERT_EQ(built["k11"].get<int>(), 11);
+    ASSERT_EQ(built.items()[10].name(), "k11");
+    ASSERT_EQ(built.items().size(), 1999);
+
+    ulib::json copy = built;
+    ASSERT_EQ(copy["k1998"].get<int>(), 1998);
+    copy["k10"] = -1;
+    ASSERT_EQ(copy.items().back().name(), "k10");
+    ASSERT_FALSE(built.find("k10"));
+
+    // items reordered and renamed in place keep their count, lookups must not trust old positions
+    auto items = copy.items();
+    std::sort(items.begin(), items.end(),
+              [](const ulib::json::ItemT &a, const ulib::json::ItemT &b) { return a.get<int>() > b.get<int>(); });
+    ASSERT_EQ(copy.items()[0].name(), "k1999");
+    ASSERT_EQ(std::as_const(copy).at("k5").get<int>(), 5);
+    ASSERT_EQ(copy["k1998"].get<int>(), 1998);
+    ASSERT_EQ(copy.find("k10")->get<int>(), -1);
+
+    copy.items()[0].set_name("renamed");
+    ASSERT_FALSE(copy.find("k1999"));
+    ASSERT_EQ(copy["renamed"].get<int>(), 1999);
+    copy["k1999"] = 0;
+    ASSERT_EQ(copy.items().size(), 2001);
+    ASSERT_EQ(copy["k1999"].get<int>(), 0);
+
+    std::string str = "{";
+    for (int i = 0; i < 500; i++)
+        str += "\"k" + std::to_string(i) + "\": " + std::to_string(i) + ", ";
+    str += "\"k7\": -7}";
+
+    // the index finds the first of duplicate keys, like a scan does
+    ulib::json::parse_options options;
+    options.duplicates = ulib::json::duplicate_keys::keep_all;
+    auto parsed = ulib::json::parse(str, options);
+    ASSERT_EQ(parsed.items().size(), 501);
+    ASSERT_EQ(parsed["k7"].get<int>(), 7);
+    ASSERT_EQ(parsed["k499"].get<int>(), 499);
+
+    options.duplicates = ulib::json::duplicate_keys::last_wins;
+    options.reuse_storage = true;
+    ulib::json::parser prsr{options};
+    ulib::json reused;
+    prsr.parse(str, reused);
+    ASSERT_EQ(reused["k7"].get<int>(), -7);
+
+    // the same items renamed in place
+    std::string renamed = str;
+    for (size_t pos = 0; (pos = renamed.find("\"k", pos)) != std::string::npos; pos++)
+        renamed[pos + 1] = 'r';
+    prsr.parse(renamed, reused);
+    ASSERT_FALSE(reused.find("k7"));
+    ASSERT_EQ(reused["r7"].get<int>(), -7);
+    ASSERT_EQ(reused["r300"].get<int>(), 300);
+
+    ulib::json::push_parser push;
+    push.feed(str);
+    auto pushed = push.take();
+    ASSERT_EQ(pushed["k7"].get<int>(), -7);
+    ASSERT_EQ(pushed["k250"].get<int>(), 250);
+
+    ulib::json::document doc;
+    doc.parse(str);
+    ASSERT_EQ(doc["k499"].get<int>(), 499);
+}
+
+TEST(Tree, CompactNodes)
+{
+    ASSERT_EQ(sizeof(ulib::json), 16);
+
+    std::string longer(100, 'x');
+    for (size_t size : {0, 1, 13, 14, 15, 100})
+    {
+        std::string text = longer.substr(0, size);
+        ulib::json value = text;
+        ASSERT_EQ(value.get<std::string>(), text);
+
+        ulib::json copy = value;
+        ulib::json moved = std::move(value);
+        ASSERT_EQ(copy.get<std::string>(), text);
+        ASSERT_EQ(moved.get<std::string>(), text);
+    }
+
+    // a long string keeps its buffer for shorter ones, short ones are stored inline
+    ulib::json value = longer;
+    value = "short";
+    ASSERT_EQ(value.get<std::string>(), "short");
+    value = longer + longer;
+    ASSERT_EQ(value.get<std::string>(), longer + longer);
+    auto own = value.get<ulib::string_view>();
+    value = ulib::string_view{own.data() + 50, own.size() - 50};
+    ASSERT_EQ(value.get<std::string>().size(), 150);
+
+    ulib::json numbers;
+    for (int i = 0; i < 1000; i++)
+        numbers.push_back() = i % 3 == 0 ? ulib::json(i) : i % 3 == 1 ? ulib::json(i * 0.5) : ulib::json("s" + std::to_string(i));
+
+    ulib::json parsed = ulib::json::parse(numbers.dump());
+    ASSERT_EQ(parsed.size(), 1000);
+    ASSERT_EQ(parsed[999].get<int>(), 999);
+    ASSERT_EQ(parsed[998].get<std::string>(), "s998");
+    ASSERT_EQ(parsed[997].get<double>(), 498.5);
+    ASSERT_EQ(parsed.dump(), numbers.dump());
+
+    // a value reset through an empty optional
+    std::optional<int> none;
+    parsed[0] = none;
+    ASSERT_TRUE(parsed[0].is_null());
+}
+
+TEST(Tree, InlineKeys)
+{
+    std::string longer(40, 'k');
+    ulib::json value;
+    for (size_t size : {0, 1, 15, 16, 17, 40})
+        value[longer.substr(0, size)] = int(size);
+
+    for (size_t size : {0, 1, 15, 16, 17, 40})
+        ASSERT_EQ(value[longer.substr(0, size)].get<size_t>(), size);
+    ASSERT_EQ(value.items()[0].name().size(), 0);
+
+    // names of the same size and prefix
+    ASSERT_FALSE(value.find("kkkkkkkkkkkkkkkx"));
+    ASSERT_FALSE(value.find(longer.substr(0, 39) + "x"));
+
+    ulib::json copy = value;
+    ulib::json moved = std::move(copy);
+    ASSERT_EQ(moved.items()[3].name(), longer.substr(0, 16));
+    ASSERT_EQ(moved.items()[5].name(), longer);
+    ASSERT_EQ(moved[longer].get<int>(), 40);
+
+    moved.items()[3].set_name("renamed_key_____");
+    ASSERT_EQ(moved["renamed_key_____"].get<int>(), 16);
+    ASSERT_FALSE(moved.find(longer.substr(0, 16)));
+
+    ulib::json::parse_options options;
+    options.duplicates = ulib::json::duplicate_keys::reject;
+    ASSERT_THROW(ulib::json::parse(R"({"a": 1, "b": 2, "a": 3})", options), ulib::ParseError);
+    auto parsed = ulib::json::parse(R"({"short": 1, "a_key_longer_than_sixteen": 2, "": 3})", options);
+    ASSERT_EQ(parsed["a_key_longer_than_sixteen"].get<int>(), 2);
+    ASSERT_EQ(parsed[""].get<int>(), 3);
+}
+
+TEST(Tree, LazyNumbers)
+{
+    std::string str = R"([3.141592653589793238462643383279, 1e400, -0.0, 12, -7, 123456789012345678901234, 1.50])";
+
+    ulib::json::parse_options options;
+    options.numbers = ulib::json::number_mode::lazy;
+    auto value = ulib::json::parse(str, options);
+
+    // dump writes the text that was read, get<T>() converts it
+    ASSERT_EQ(value.dump(), R"([3.141592653589793238462643383279,1e400,-0.0,12,-7,123456789012345678901234,1.50])");
+    ASSERT_EQ(value[0].number_text(), "3.141592653589793238462643383279");
+    ASSERT_TRUE(value[0].is_float());
+    ASSERT_DOUBLE_EQ(value[0].get<double>(), 3.141592653589793);
+    ASSERT_EQ(value[3].get<int>(), 12);
+    ASSERT_TRUE(value[4].is_int());
+    ASSERT_EQ(value[4].get<int64_t>(), -7);
+    ASSERT_EQ(value[4].get<double>(), -7.0);
+    ASSERT_EQ(value[5].number_text(), "123456789012345678901234");
+    ASSERT_TRUE(value[5].is_float());
+    ASSERT_TRUE(ulib::json::parse("18446744073709551615", options).get<uint64_t>() == UINT64_MAX);
+
+    ulib::json copy = value;
+    ASSERT_EQ(copy.dump(), value.dump());
+    ASSERT_EQ(copy[0].number_text(), value[0].number_text());
+    ASSERT_NE(copy[0].number_text().data(), value[0].number_text().data());
+
+    // an assigned number is a decoded one
+    copy[0] = 2;
+    ASSERT_EQ(copy[0].number_text(), "");
+    ASSERT_EQ(copy[0].get<int>(), 2);
+    copy[6] = 0.25;
+    ASSERT_EQ(copy[6].get<double>(), 0.25);
+    copy[3] = ulib::json{};
+    ASSERT_TRUE(copy[3].is_null());
+    ASSERT_EQ(copy.dump(), R"([2,1e400,-0.0,null,-7,123456789012345678901234,0.25])");
+
+    ASSERT_THROW(ulib::json::parse("[1.]", options), ulib::ParseError);
+    ASSERT_THROW(ulib::json::parse("[01]", options), ulib::ParseError);
+
+    // in situ, text that doesn't fit the node points into the input
+    options.in_situ = true;
+    auto borrowed = ulib::json::parse(str, options);
+    auto text = borrowed[0].number_text();
+    ASSERT_TRUE(text.data() >= str.data() && text.data() < str.data() + str.size());
+    ASSERT_EQ(borrowed.dump(), value.dump());
+
+    options.in_situ = false;
+    ulib::json::push_parser push{options};
+    push.feed(str.substr(0, 10));
+    push.feed(str.substr(10));
+    ASSERT_EQ(push.take().dump(), value.dump());
+
+    ulib::json::document doc;
+    doc.parse(str, options);
+    ASSERT_EQ(doc.root().dump(), value.dump());
+}
+
+TEST(Tree, TapeDocument)
+{
+    std::string str = R"({"name": "tape", "escaped": "a\nb", "list": [1, -2, 18446744073709551615, 2.5, true, null, [], {}],
+                         "nested": {"a": {"b": [10, 20, 30]}, "c": false}, "name": "second"})";
+
+    ulib::json::tape_document doc;
+    doc.parse(str);
+
+    auto root = doc.root();
+    ASSERT_EQ(root.type(), ulib::json::value_t::object);
+    ASSERT_EQ(root.size(), 4);
+    ASSERT_EQ(root["name"].get<ulib::string_view>(), "second"); // first position, last value
+    ASSERT_EQ(root["escaped"].get<std::string>(), "a\nb");
+    ASSERT_EQ(doc["nested"]["a"]["b"][2].get<int>(), 30);
+    ASSERT_FALSE(root["nested"]["c"].get<bool>());
+    ASSERT_FALSE(root.find("missing"));
+    ASSERT_THROW(root["missing"], ulib::json::exception);
+    ASSERT_THROW(root["list"][8], ulib::json::exception);
+    ASSERT_THROW(root["name"].get<int>(), ulib::json::exception);
+
+    auto list = root["list"];
+    ASSERT_EQ(list.size(), 8);
+    ASSERT_EQ(list[1].get<int64_t>(), -2);
+    ASSERT_EQ(list[2].get<uint64_t>(), UINT64_MAX);
+    ASSERT_EQ(list[3].get<double>(), 2.5);
+    ASSERT_TRUE(list[5].is_null());
+    ASSERT_EQ(list[6].size(), 0);
+    ASSERT_EQ(list[7].size(), 0);
+
+    // containers are stepped over with their skip offsets
+    std::vector<std::string> names;
+    for (auto &item : root.items())
+        names.emplace_back(item.name().data(), item.name().size());
+    ASSERT_EQ(names, (std::vector<std::string>{"name", "escaped", "list", "nested"}));
+
+    int64_t sum = 0;
+    for (auto &value : root["nested"]["a"]["b"].values())
+        sum += value.get<int64_t>();
+    ASSERT_EQ(sum, 60);
+
+    // materialized like the tree parser would build it
+    ASSERT_EQ(root["list"].value().dump(), ulib::json::parse(R"([1, -2, 18446744073709551615, 2.5, true, null, [], {}])").dump());
+    ASSERT_EQ(root["nested"].value()["a"]["b"][0].get<int>(), 10);
+
+    // the buffers are kept, views into the previous parse are not
+    size_t words = doc.tape_size();
+    doc.parse(R"([[1, 2], "x"])");
+    ASSERT_LT(doc.tape_size(), words);
+    ASSERT_EQ(doc[1].get<std::string>(), "x");
+    ASSERT_EQ(doc[0][1].get<int>(), 2);
+
+    // more elements than the count field holds
+    std::string large = "[";
+    for (int i = 0; i < 0x1000000 + 5; i++)
+        large += i ? ",0" : "0";
+    large += "]";
+    doc.parse(large);
+    ASSERT_EQ(doc.root().size(), 0x1000000 + 5);
+
+    // an object whose keys and values overflow the count before a nested container
+    ulib::json::parse_options all;
+    all.duplicates = ulib::json::duplicate_keys::keep_all;
+    large = "{";
+    for (int i = 0; i < 0x800000 + 5; i++)
+        large += "\"a\":0,";
+    large += "\"b\": [1]}";
+    doc.parse(large, all);
+    ASSERT_EQ(doc.root().size(), 0x800000 + 6);
+    ASSERT_EQ(doc["b"].size(), 1);
+
+    // duplicates resolved like the tree parser, the values moved down keep their skip offsets
+    std::string repeated = R"({"a": [1, {"x": 2}], "b": {"c": [3]}, "a": {"y": [4, 5.5]}, "b": 6, "d": [7, {"z": 8}]})";
+    for (auto policy : {ulib::json::duplicate_keys::last_wins, ulib::json::duplicate_keys::first_wins,
+                        ulib::json::duplicate_keys::keep_all})
+    {
+        ulib::json::parse_options options;
+        options.duplicates = policy;
+        doc.parse(repeated, options);
+        ASSERT_EQ(doc.root().value().dump(), ulib::json::parse(repeated, options).dump());
+        ASSERT_EQ(doc["d"][1]["z"].get<int>(), 8);
+    }
+
+    std::string wide = "{";
+    for (int i = 0; i < 40; i++)
+        wide += "\"k" + std::to_string(i % 20) + "\": [" + std::to_string(i) + "],";
+    wide += "\"end\": {}}";
+    doc.parse(wide);
+    ASSERT_EQ(doc.root().size(), 21);
+    ASSERT_EQ(doc["k3"][0].get<int>(), 23);
+    ASSERT_EQ(doc.root().value().dump(), ulib::json::parse(wide).dump());
+
+    ulib::json::parse_options reject;
+    reject.duplicates = ulib::json::duplicate_keys::reject;
+    ASSERT_THROW(doc.parse(R"({"a": {"b": 1, "b": 2}})", reject), ulib::ParseError);
+    ASSERT_THROW(doc.parse(wide, reject), ulib::ParseError);
+
+    ASSERT_THROW(doc.parse(R"({"a": [1, 2})"), ulib::ParseError);
+    ASSERT_THROW(doc.root(), ulib::json::exception);
+}
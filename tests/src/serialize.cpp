@@ -2,6 +2,9 @@
 
 #include <ulib/json.h>
 
+#include <cmath>
+#include <limits>
+
 TEST(Tree, CanSerializeBool)
 {
     ASSERT_EQ(ulib::json{true}.dump(), "true");
@@ -121,9 +124,38 @@ TEST(Tree, DumpEmptyTypes)
     ASSERT_EQ(ulib::json{ulib::json::value_t::array}.dump(), "[]");
     ASSERT_EQ(ulib::json{ulib::json::value_t::boolean}.dump(), "false");
     ASSERT_EQ(ulib::json{ulib::json::value_t::integer}.dump(), "0");
-    ASSERT_EQ(ulib::json{ulib::json::value_t::floating}.dump(), "0.000000");
+    ASSERT_EQ(ulib::json{ulib::json::value_t::floating}.dump(), "0.0");
     ASSERT_EQ(ulib::json{ulib::json::value_t::string}.dump(), "\"\"");
 
     ASSERT_EQ(ulib::json::object().dump(), "{}");
     ASSERT_EQ(ulib::json::array().dump(), "[]");
-}
\ No newline at end of file
+}
+
+TEST(Tree, SerializeUnsigned)
+{
+    ASSERT_EQ(ulib::json{uint64_t(18446744073709551615ULL)}.dump(), "18446744073709551615");
+    ASSERT_EQ(ulib::json::parse("18446744073709551615").dump(), "18446744073709551615");
+    ASSERT_EQ(ulib::json{uint32_t(7)}.type(), ulib::json::value_t::integer);
+}
+
+TEST(Tree, SerializeFloating)
+{
+    ASSERT_EQ(ulib::json::parse("[1e-10, 0.1, 1.7976931348623157e308, -2.5, 3.0, 0]").dump(),
+              "[1e-10,0.1,1.7976931348623157e+308,-2.5,3.0,0]");
+
+    // json has neither infinity nor NaN
+    ulib::json special;
+    special.push_back() = std::numeric_limits<double>::infinity();
+    special.push_back() = std::numeric_limits<double>::quiet_NaN();
+    ASSERT_EQ(special.dump(), "[null,null]");
+
+    // parse(dump(x)) gives back every double and keeps it floating
+    for (double d : {0.1, 1.0 / 3, 5e-324, 2.2250738585072014e-308, 1e22, 123456789012345680.0, -0.0, 4.35, 1e21})
+    {
+        ulib::json value = d;
+        ulib::json parsed = ulib::json::parse(value.dump());
+        ASSERT_TRUE(parsed.is_float());
+        ASSERT_EQ(parsed.get<double>(), d);
+        ASSERT_EQ(std::signbit(parsed.get<double>()), std::signbit(d));
+    }
+}
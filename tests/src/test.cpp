@@ -57,6 +57,33 @@ TEST(JsonTree, Search)
     // ASSERT_EQ(value.dump(), "\"full\\nplak\"");
 }
 
+TEST(JsonTree, FindWithoutExceptions)
+{
+    ulib::json value;
+    value["port"] = 25005;
+    value["name"] = "server";
+    value["list"].push_back() = 1.5;
+
+    auto port = value.find("port");
+    ASSERT_TRUE(port);
+    ASSERT_EQ(port->get<int>(), 25005);
+    ASSERT_EQ(port->get_result<int>().value(), 25005);
+
+    ASSERT_EQ(value.find("missing").error(), ulib::json::errc::key_not_found);
+    ASSERT_EQ(value["name"].find("x").error(), ulib::json::errc::not_an_object);
+    ASSERT_EQ(value.find(0).error(), ulib::json::errc::not_an_array);
+    ASSERT_EQ(value["list"].find(1).error(), ulib::json::errc::index_out_of_range);
+    ASSERT_EQ(value["list"].find(0)->get_result<double>().value_or(0.0), 1.5);
+
+    ASSERT_EQ(value["name"].get_result<int>().error(), ulib::json::errc::wrong_type);
+    ASSERT_EQ(value["name"].get_result<int>().value_or(-1), -1);
+    ASSERT_TRUE(value["name"].get_result<ulib::string>().value() == "server");
+    ASSERT_ANY_THROW(value.find("missing").value());
+
+    *value.find("port") = 80;
+    ASSERT_EQ(value["port"].get<int>(), 80);
+}
+
 TEST(JsonTree, EncodingsInConstruct)
 {
     {
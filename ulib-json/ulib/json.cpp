@@ -1,9 +1,35 @@
 #include "json.h"
 
+#include <utility>
+
 namespace ulib
 {
+    static_assert(sizeof(json) == 16, "json nodes are 16 bytes");
+
+    template <class T, class... Args>
+    static T *new_container(Args &&...args)
+    {
+        void *p = json_allocator{}.Alloc(sizeof(T));
+        try
+        {
+            return new (p) T(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            json_allocator{}.Free(p);
+            throw;
+        }
+    }
+
+    template <class T>
+    static void delete_container(T *container)
+    {
+        container->~T();
+        json_allocator{}.Free(container);
+    }
+
     json::json(const json &v) { copy_construct_from_other(v); }
-    json::json(json &&v) { move_construct_from_other(std::move(v)); }
+    json::json(json &&v) noexcept { move_construct_from_other(std::move(v)); }
     json::json(value_t t) { construct_from_type(t); }
 
     json::~json() { destroy_containers(); }
@@ -25,34 +51,35 @@ namespace ulib
     json &json::push_back()
     {
         implicit_touch_array();
-        return mArray.emplace_back();
+        return mArray->emplace_back();
     }
 
     // if value is exists, works like "at" otherwise creates value and set value type to undefined
     json &json::find_or_create(StringViewT name)
     {
-        if (implicit_touch_object())
-            return mObject.emplace_back(name).value();
-
-        for (auto &obj : mObject)
-            if (obj.name() == name)
-                return obj.value();
+        if (!implicit_touch_object())
+        {
+            if (json *found = find_object_in_object(name))
+                return *found;
+        }
 
-        return mObject.emplace_back(name).value();
+        json &value = mObject->emplace_back(name).value();
+        mObject->appended();
+        return value;
     }
 
     json &json::find_or_create(size_t idx)
     {
         if (implicit_touch_array())
-            return mArray.emplace_back();
+            return mArray->emplace_back();
 
-        if (idx >= mArray.size())
+        if (idx >= mArray->size())
         {
-            mArray.resize(idx + 1);
-            return mArray.back();
+            mArray->resize(idx + 1);
+            return mArray->back();
         }
 
-        return mArray[idx];
+        return (*mArray)[idx];
     }
 
     const json &json::find_if_exists(StringViewT name) const
@@ -62,9 +89,8 @@ namespace ulib
 
         implicit_const_touch_object();
 
-        for (auto &obj : mObject)
-            if (obj.name() == name)
-                return obj.value();
+        if (const json *found = find_object_in_object(name))
+            return *found;
 
         throw exception{ulib::string{"in json find_if_exists(\""} + name + "\")" + " key not found"};
     }
@@ -75,31 +101,31 @@ namespace ulib
             throw exception{ulib::string{"in json find_if_exists("} + std::to_string(idx) + ")" +
                             " json must be an array"};
 
-        if (idx >= mArray.size())
+        if (idx >= mArray->size())
             throw exception{ulib::string{"in json find_if_exists("} + std::to_string(idx) + ")" +
-                            " index out of range. Array size is " + std::to_string(mArray.size())};
+                            " index out of range. Array size is " + std::to_string(mArray->size())};
         // throw exception{"json array index out of range"};
 
-        return mArray[idx];
+        return (*mArray)[idx];
     }
 
     // private: -----------------------
 
     void json::initialize_as_string()
     {
-        new (&mString) StringT;
+        mFlags = kInlineString;
         mType = value_t::string;
     }
 
     void json::initialize_as_object()
     {
-        new (&mObject) ObjectT;
+        mObject = new_container<ObjectT>();
         mType = value_t::object;
     }
 
     void json::initialize_as_array()
     {
-        new (&mArray) ArrayT;
+        mArray = new_container<ArrayT>();
         mType = value_t::array;
     }
 
@@ -168,47 +194,32 @@ namespace ulib
 
     void json::implicit_set_string(StringViewT other)
     {
-        if (mType == value_t::string)
-        {
-            mString.assign(other);
-            return;
-        }
-
-        if (mType != value_t::null)
+        if (mType != value_t::string && mType != value_t::null)
             throw json::exception(
                 ulib::string{"json value must be a string or null while implicit set string. current: "} +
                 type_to_string(mType));
 
-        new (&mString) StringT(other);
+        set_chars(other);
         mType = value_t::string;
     }
 
     void json::implicit_move_set_string(StringT &&other)
     {
-        if (mType == value_t::string)
-        {
-            mString.assign(std::move(other));
-            return;
-        }
-
-        if (mType != value_t::null)
-            throw json::exception(
-                ulib::string{"json value must be a string or null while implicit set string. current: "} +
-                type_to_string(mType));
-
-        new (&mString) StringT(std::move(other));
-        mType = value_t::string;
+        implicit_set_string(StringViewT{other.raw_data(), other.size()});
     }
 
-    void json::implicit_set_float(float other)
+    void json::implicit_set_float(double other)
     {
+        if (mFlags & kNumberText)
+            implicit_set_type(value_t::null);
+
         if (mType == value_t::floating)
         {
             mFloatVal = other;
             return;
         }
 
-        if (mType == value_t::integer)
+        if (mType == value_t::integer || mType == value_t::unsigned_integer)
         {
             mFloatVal = other, mType = value_t::floating;
             return;
@@ -223,13 +234,16 @@ namespace ulib
     }
     void json::implicit_set_integer(int64_t other)
     {
+        if (mFlags & kNumberText)
+            implicit_set_type(value_t::null);
+
         if (mType == value_t::integer)
         {
             mIntVal = other;
             return;
         }
 
-        if (mType == value_t::floating)
+        if (mType == value_t::floating || mType == value_t::unsigned_integer)
         {
             mIntVal = other, mType = value_t::integer;
             return;
@@ -243,6 +257,25 @@ namespace ulib
         mIntVal = other, mType = value_t::integer;
     }
 
+    void json::implicit_set_unsigned(uint64_t other)
+    {
+        if (other <= uint64_t(INT64_MAX))
+        {
+            implicit_set_integer(int64_t(other));
+            return;
+        }
+
+        if (mType != value_t::null && !is_number())
+            throw json::exception(
+                ulib::string{"json value must be a numeric or null while implicit set string. current: "} +
+                type_to_string(mType));
+
+        if (mFlags & kNumberText)
+            implicit_set_type(value_t::null);
+
+        mUIntVal = other, mType = value_t::unsigned_integer;
+    }
+
     void json::implicit_set_boolean(bool other)
     {
         if (mType == value_t::boolean)
@@ -271,6 +304,10 @@ namespace ulib
             mFloatVal = 0;
             mType = value_t::floating;
             break;
+        case value_t::unsigned_integer:
+            mUIntVal = 0;
+            mType = value_t::unsigned_integer;
+            break;
         case value_t::boolean:
             mBoolVal = false;
             mType = value_t::boolean;
@@ -292,55 +329,55 @@ namespace ulib
 
     void json::construct_as_string(StringViewT other)
     {
-        new (&mString) StringT(other);
+        mType = value_t::null;
+        set_chars(other);
         mType = value_t::string;
     }
 
     void json::move_construct_as_string(StringT &&other)
     {
-        new (&mString) StringT(std::move(other));
-        mType = value_t::string;
+        construct_as_string(StringViewT{other.raw_data(), other.size()});
     }
 
     void json::copy_construct_from_other(const json &other)
     {
+        mType = value_t::null;
+        mFlags = 0;
+
         switch (other.mType)
         {
         case value_t::object:
-            new (&mObject) ObjectT(other.mObject);
+            mObject = new_container<ObjectT>(*other.mObject);
             break;
         case value_t::array:
-            new (&mArray) ArrayT(other.mArray);
+            mArray = new_container<ArrayT>(*other.mArray);
             break;
         case value_t::string:
-            new (&mString) StringT(other.mString);
+            set_chars(other.string_ref());
             break;
         default:
-            mIntVal = other.mIntVal;
+            if (other.mFlags & kNumberText)
+            {
+                set_chars(other.string_ref());
+                mFlags |= kNumberText;
+            }
+            else
+            {
+                memcpy(inline_chars(), other.inline_chars(), kInlineCapacity);
+            }
         }
 
         mType = other.mType;
     }
 
+    // every kind of value is moved with the bytes of the node
     void json::move_construct_from_other(json &&other)
     {
-        switch (other.mType)
-        {
-        case value_t::object:
-            new (&mObject) ObjectT(std::move(other.mObject));
-            break;
-        case value_t::array:
-            new (&mArray) ArrayT(std::move(other.mArray));
-            break;
-        case value_t::string:
-            new (&mString) StringT(std::move(other.mString));
-            break;
-        default:
-            mIntVal = other.mIntVal;
-        }
-
+        memcpy(inline_chars(), other.inline_chars(), kInlineCapacity);
         mType = other.mType;
+        mFlags = other.mFlags;
         other.mType = value_t::null;
+        other.mFlags = 0;
     }
 
     void json::destroy_containers()
@@ -348,36 +385,296 @@ namespace ulib
         switch (mType)
         {
         case value_t::object:
-            mObject.~ObjectT();
+            delete_container(mObject);
             break;
         case value_t::array:
-            mArray.~ArrayT();
+            delete_container(mArray);
             break;
         case value_t::string:
-            mString.~StringT();
+            release_chars();
             break;
 
         default:
+            if (mFlags & kNumberText)
+                release_chars();
             break;
         }
+
+        mFlags = 0;
     }
 
-    json *json::find_object_in_object(StringViewT name)
+    // Owned text is preceded by the capacity of its buffer, which is kept while the text fits
+    // so reused storage doesn't allocate
+    void json::set_chars(StringViewT str)
+    {
+        size_t size = str.size();
+        if (mType == value_t::string && !(mFlags & (kBorrowedString | kInlineString)))
+        {
+            uint32_t capacity;
+            memcpy(&capacity, mChars - sizeof(capacity), sizeof(capacity));
+            if (size <= capacity)
+            {
+                memmove((char *)mChars, str.data(), size);
+                mSize = uint32_t(size);
+                return;
+            }
+
+            release_chars();
+        }
+
+        if (size <= kInlineCapacity)
+        {
+            memmove(inline_chars(), str.data(), size);
+            mFlags = uint8_t(kInlineString | (size << kInlineSizeShift));
+            return;
+        }
+
+        if (size > UINT32_MAX)
+            throw json::exception(ulib::string{"json string is too long: "} + std::to_string(size) + " bytes");
+
+        uint32_t capacity = uint32_t(size);
+        char *buffer = (char *)json_allocator{}.Alloc(sizeof(capacity) + size);
+        memcpy(buffer, &capacity, sizeof(capacity));
+        memcpy(buffer + sizeof(capacity), str.data(), size);
+
+        mChars = buffer + sizeof(capacity);
+        mSize = capacity;
+        mFlags = 0;
+    }
+
+    void json::release_chars()
+    {
+        if (!(mFlags & (kBorrowedString | kInlineString)))
+            json_allocator{}.Free((char *)mChars - sizeof(uint32_t));
+
+        mFlags = kInlineString;
+    }
+
+    void json::set_borrowed_string(StringViewT str)
+    {
+        destroy_containers();
+        mType = value_t::null;
+
+        if (str.size() > UINT32_MAX)
+        {
+            set_chars(str);
+        }
+        else
+        {
+            mChars = str.data();
+            mSize = uint32_t(str.size());
+            mFlags = kBorrowedString;
+        }
+
+        mType = value_t::string;
+    }
+
+    void json::set_number_text(StringViewT text, value_t type, bool borrow)
+    {
+        destroy_containers();
+        mType = value_t::null;
+
+        if (borrow && text.size() > kInlineCapacity && text.size() <= UINT32_MAX)
+        {
+            mChars = text.data();
+            mSize = uint32_t(text.size());
+            mFlags = kBorrowedString;
+        }
+        else
+        {
+            set_chars(text);
+        }
+
+        mFlags |= kNumberText;
+        mType = type;
+    }
+
+    json_detail::number json::decode_number() const noexcept
+    {
+        StringViewT text = string_ref();
+        json_detail::number num;
+        json_detail::parse_number(text.data(), text.data() + text.size(), num);
+        return num;
+    }
+
+    json::value_t json::lazy_number_type(StringViewT text, size_t int_digits, bool integral)
+    {
+        if (!integral)
+            return value_t::floating;
+        if (int_digits <= 18)
+            return value_t::integer;
+
+        json_detail::number num;
+        json_detail::parse_number(text.data(), text.data() + text.size(), num);
+        switch (num.kind)
+        {
+        case json_detail::number_kind::integer:
+            return value_t::integer;
+        case json_detail::number_kind::unsigned_integer:
+            return value_t::unsigned_integer;
+        default:
+            return value_t::floating;
+        }
+    }
+
+    json::result<const json &> json::find(StringViewT name) const
+    {
+        if (mType != value_t::object)
+            return errc::not_an_object;
+
+        const json *found = find_object_in_object(name);
+        if (!found)
+            return errc::key_not_found;
+
+        return *found;
+    }
+
+    json::result<json &> json::find(StringViewT name)
+    {
+        if (mType != value_t::object)
+            return errc::not_an_object;
+
+        json *found = find_object_in_object(name);
+        if (!found)
+            return errc::key_not_found;
+
+        return *found;
+    }
+
+    json::result<const json &> json::find(size_t idx) const
     {
-        for (auto &obj : mObject)
-            if (obj.name() == name)
-                return &obj;
+        if (mType != value_t::array)
+            return errc::not_an_array;
 
-        return nullptr;
+        if (idx >= mArray->size())
+            return errc::index_out_of_range;
+
+        return (*mArray)[idx];
+    }
+
+    json::result<json &> json::find(size_t idx)
+    {
+        if (mType != value_t::array)
+            return errc::not_an_array;
+
+        if (idx >= mArray->size())
+            return errc::index_out_of_range;
+
+        return (*mArray)[idx];
+    }
+
+    json *json::find_object_in_object(StringViewT name)
+    {
+        mObject->restore_index();
+        return const_cast<json *>(std::as_const(*this).find_object_in_object(name));
     }
 
     const json *json::find_object_in_object(StringViewT name) const
     {
-        for (auto &obj : mObject)
-            if (obj.name() == name)
-                return &obj;
+        size_t pos = mObject->find(name);
+        return pos != mObject->size() ? &(*mObject)[pos] : nullptr;
+    }
+
+    // keys are told apart by size and hash prefix, their text is only read to confirm a match
+    size_t json::object_list::find(StringViewT name) const
+    {
+        if (mIndex.covers(size()))
+            return mIndex.find(*this, name);
+
+        uint64_t hash = json_detail::hash_key(name.data(), name.size());
+        for (size_t i = 0; i != size(); i++)
+        {
+            if ((*this)[i].key().equals(name, hash))
+                return i;
+        }
+
+        return size();
+    }
+
+    void json::object_list::appended()
+    {
+        if (mIndex.covers(size() - 1))
+            mIndex.insert(*this);
+        else if (size() >= kIndexThreshold)
+            mIndex.build(*this);
+    }
+
+    void json::object_list::reindex()
+    {
+        if (size() >= kIndexThreshold)
+            mIndex.build(*this);
+        else
+            mIndex.reset();
+    }
+
+    void json::object_list::restore_index()
+    {
+        if (size() >= kIndexThreshold && !mIndex.covers(size()))
+            mIndex.build(*this);
+    }
+
+    void json::object_index::reset()
+    {
+        json_allocator{}.Free(mTable);
+        mTable = nullptr;
+    }
+
+    // a name already present keeps the position of its first item, like a scan finds it
+    void json::object_index::build(const object_list &items)
+    {
+        size_t capacity = 64;
+        while (capacity < items.size() * 2)
+            capacity <<= 1;
+
+        reset();
+        mTable = (uint32_t *)json_allocator{}.Alloc((capacity + 2) * sizeof(uint32_t));
+        memset(mTable, 0, (capacity + 2) * sizeof(uint32_t));
+        mTable[1] = uint32_t(capacity - 1);
+
+        uint32_t *slots = mTable + 2;
+        for (size_t pos = 0; pos != items.size(); pos++)
+        {
+            size_t slot = probe(items, items[pos].name());
+            if (!slots[slot])
+                slots[slot] = uint32_t(pos + 1);
+        }
+
+        mTable[0] = uint32_t(items.size());
+    }
+
+    void json::object_index::insert(const object_list &items)
+    {
+        // at half load the table is rebuilt twice as large
+        if (items.size() * 2 > size_t(mTable[1]) + 1)
+            return build(items);
+
+        uint32_t *slots = mTable + 2;
+        size_t slot = probe(items, items.back().name());
+        if (!slots[slot])
+            slots[slot] = uint32_t(items.size());
+
+        mTable[0] = uint32_t(items.size());
+    }
+
+    size_t json::object_index::find(const object_list &items, StringViewT name) const
+    {
+        uint32_t pos = mTable[2 + probe(items, name)];
+        return pos ? pos - 1 : items.size();
+    }
+
+    // the slot holding name, or the empty one ending its probe sequence
+    size_t json::object_index::probe(const object_list &items, StringViewT name) const
+    {
+        const uint32_t *slots = mTable + 2;
+        uint64_t hash = json_detail::hash_key(name.data(), name.size());
+        size_t slot = hash & mTable[1];
+        for (; slots[slot]; slot = (slot + 1) & mTable[1])
+        {
+            if (items[slots[slot] - 1].key().equals(name, hash))
+                break;
+        }
 
-        return nullptr;
+        return slot;
     }
 
 } // namespace ulib
@@ -4,11 +4,266 @@
 #include <ulib/string.h>
 #include <ulib/runtimeerror.h>
 
+#include "json_arena.h"
+#include "json_number.h"
+#include "json_tape.h"
+
+#include <cstdint>
+#include <cstring>
 #include <optional>
 #include <filesystem>
+#include <memory>
+#include <functional>
+#include <initializer_list>
+#include <utility>
 
 namespace ulib
 {
+    namespace json_detail
+    {
+        class mapped_file;
+
+        // fills a T straight from the parser's input, see json_struct.h
+        template <class T, class = void>
+        struct value_reader;
+
+        // stage 1 state carried between 64-byte blocks
+        struct scanner_state
+        {
+            uint64_t prev_in_string = 0;
+            uint64_t prev_escaped = 0;
+            uint64_t prev_scalar = 0;
+        };
+
+        // hashes 8 bytes per step, used by lookup tables over object keys
+        inline uint64_t hash_key(const char *p, size_t n)
+        {
+            uint64_t h = 0x9E3779B97F4A7C15ULL ^ n;
+            for (; n >= 8; p += 8, n -= 8)
+            {
+                uint64_t v;
+                memcpy(&v, p, 8);
+                h = (h ^ v) * 0xFF51AFD7ED558CCDULL;
+                h ^= h >> 32;
+            }
+
+            uint64_t v = 0;
+            memcpy(&v, p, n);
+
+            // every input bit reaches the low ones, tables mask them
+            h ^= v;
+            h = (h ^ (h >> 33)) * 0xFF51AFD7ED558CCDULL;
+            h = (h ^ (h >> 33)) * 0xC4CEB9FE1A85EC53ULL;
+            return h ^ (h >> 33);
+        }
+
+        // Interned key text shared by any number of trees, parsers and threads. Known keys are
+        // looked up without locking, only adding a new one takes a mutex. Equal names intern to the
+        // same text, so trees sharing a pool hold one copy of each key. Text is kept until the pool
+        // is destroyed, which must outlive every tree holding its keys
+        class key_pool
+        {
+        public:
+            key_pool();
+            key_pool(const key_pool &) = delete;
+            key_pool &operator=(const key_pool &) = delete;
+            ~key_pool();
+
+            // the pooled copy of name, added on first use
+            ulib::string_view intern(ulib::string_view name);
+            // the pooled copy of name if there is one, nothing is added
+            std::optional<ulib::string_view> find(ulib::string_view name) const;
+            size_t size() const;
+
+            // While alive, keys created on this thread without a parser's parse_options::keys
+            // are interned in pool: members added by operator[], parsed keys
+            class scope
+            {
+            public:
+                scope(key_pool *pool);
+                ~scope();
+
+            private:
+                key_pool *mPrev;
+            };
+
+            static key_pool *active();
+
+        private:
+            struct entry;
+            struct table;
+            struct state;
+
+            const entry *lookup(ulib::string_view name, uint64_t hash) const;
+
+            std::unique_ptr<state> mState;
+        };
+
+        // Name of an object member: owns a copy of its text, borrows it from the input
+        // of an in situ parse, or points into a key_pool. Owned names of up to kInlineCapacity
+        // bytes are stored in the key itself. Copies own their text unless it is pooled.
+        // The size and the top bits of hash_key are kept with the text, so comparisons
+        // reject most other names without reading it
+        class item_key
+        {
+        public:
+            static constexpr size_t kInlineCapacity = 16;
+
+            item_key() : mData(nullptr), mSize(0), mHash(prefix_of(hash_key("", 0))), mKind(kInline) {}
+            explicit item_key(ulib::string_view name)
+            {
+                if (key_pool *pool = key_pool::active())
+                    assign_pooled(pool->intern(name));
+                else
+                    assign_copy(name.data(), name.size());
+            }
+            item_key(const item_key &other) { copy_from(other); }
+            item_key(item_key &&other) noexcept { take(other); }
+            ~item_key() { release(); }
+
+            static item_key borrow(ulib::string_view name)
+            {
+                item_key key;
+                key.mData = (char *)name.data();
+                key.mSize = uint32_t(name.size());
+                key.mHash = prefix_of(hash_key(name.data(), name.size()));
+                key.mKind = kBorrowed;
+                return key;
+            }
+
+            // text returned by key_pool::intern()
+            static item_key pooled(ulib::string_view text)
+            {
+                item_key key;
+                key.assign_pooled(text);
+                return key;
+            }
+
+            item_key &operator=(const item_key &other)
+            {
+                if (this != &other)
+                    release(), copy_from(other);
+                return *this;
+            }
+
+            item_key &operator=(item_key &&other) noexcept
+            {
+                if (this != &other)
+                    release(), take(other);
+                return *this;
+            }
+
+            // an owned key of the same length is overwritten in place, the same name is kept
+            void assign(ulib::string_view name)
+            {
+                if (key_pool *pool = key_pool::active())
+                {
+                    release();
+                    assign_pooled(pool->intern(name));
+                    return;
+                }
+
+                if ((mKind == kOwned || mKind == kInline) && mSize == name.size())
+                {
+                    if (mSize && memcmp(data(), name.data(), mSize) != 0)
+                    {
+                        memcpy((char *)data(), name.data(), mSize);
+                        mHash = prefix_of(hash_key(name.data(), name.size()));
+                    }
+                    return;
+                }
+
+                release();
+                assign_copy(name.data(), name.size());
+            }
+
+            ulib::string_view view() const { return ulib::string_view{data(), size_t(mSize)}; }
+            const char *data() const { return mKind == kInline ? mInline : mData ? mData : ""; }
+            size_t size() const { return mSize; }
+            bool borrowed() const { return mKind == kBorrowed; }
+            bool pooled() const { return mKind == kPooled; }
+
+            // hash: hash_key() of name
+            bool equals(ulib::string_view name, uint64_t hash) const
+            {
+                return mSize == name.size() && mHash == prefix_of(hash) && memcmp(data(), name.data(), mSize) == 0;
+            }
+
+            bool operator==(const item_key &other) const
+            {
+                return mSize == other.mSize && mHash == other.mHash && memcmp(data(), other.data(), mSize) == 0;
+            }
+
+        private:
+            static constexpr uint8_t kOwned = 0;
+            static constexpr uint8_t kBorrowed = 1;
+            static constexpr uint8_t kPooled = 2;
+            static constexpr uint8_t kInline = 3;
+
+            static uint16_t prefix_of(uint64_t hash) { return uint16_t(hash >> 48); }
+
+            void assign_copy(const char *data, size_t size)
+            {
+                if (size <= kInlineCapacity)
+                {
+                    if (size)
+                        memcpy(mInline, data, size);
+                    mKind = kInline;
+                }
+                else
+                {
+                    mData = (char *)json_allocator{}.Alloc(size);
+                    memcpy(mData, data, size);
+                    mKind = kOwned;
+                }
+
+                mSize = uint32_t(size);
+                mHash = prefix_of(hash_key(data, size));
+            }
+
+            void assign_pooled(ulib::string_view text)
+            {
+                mData = (char *)text.data();
+                mSize = uint32_t(text.size());
+                mHash = prefix_of(hash_key(text.data(), text.size()));
+                mKind = kPooled;
+            }
+
+            void copy_from(const item_key &other)
+            {
+                if (other.mKind == kOwned || other.mKind == kBorrowed)
+                {
+                    assign_copy(other.mData, other.mSize);
+                    return;
+                }
+
+                memcpy(mInline, other.mInline, kInlineCapacity);
+                mSize = other.mSize, mHash = other.mHash, mKind = other.mKind;
+            }
+
+            void take(item_key &other)
+            {
+                memcpy(mInline, other.mInline, kInlineCapacity);
+                mSize = other.mSize, mHash = other.mHash, mKind = other.mKind;
+                other.mSize = 0, other.mKind = kInline;
+            }
+
+            void release()
+            {
+                if (mKind == kOwned)
+                    json_allocator{}.Free(mData);
+            }
+
+            union {
+                char *mData;
+                char mInline[kInlineCapacity];
+            };
+            uint32_t mSize;
+            uint16_t mHash;
+            uint8_t mKind;
+        };
+    } // namespace json_detail
+
     // template <class JsonTy, class T>
     // struct json_iterator : public BaseIterator<T, std::random_access_iterator_tag>
     // {
@@ -62,11 +317,15 @@ namespace ulib
     //     size_t mIndex;
     // };
 
+    ULIB_RUNTIME_ERROR(ParseError);
+
     class json
     {
     public:
         ULIB_RUNTIME_ERROR(exception);
 
+        using key_pool = json_detail::key_pool;
+
         template <class JsonTy>
         class basic_item : public JsonTy
         {
@@ -78,19 +337,38 @@ namespace ulib
 
             basic_item() : JsonT(), mName() {}
             basic_item(const basic_item &other) : JsonT(other), mName(other.mName) {}
+            basic_item(basic_item &&other) noexcept : JsonT(std::move(other)), mName(std::move(other.mName)) {}
             basic_item(StringViewT name) : JsonT(), mName(name) {}
+            basic_item(json_detail::item_key &&name) : JsonT(), mName(std::move(name)) {}
             ~basic_item() {}
 
+            basic_item &operator=(const basic_item &other)
+            {
+                JsonT::operator=(other);
+                mName = other.mName;
+                return *this;
+            }
+
+            basic_item &operator=(basic_item &&other)
+            {
+                JsonT::operator=(std::move(other));
+                mName = std::move(other.mName);
+                return *this;
+            }
+
             // ulib::string_view name() { return this->name(); }
-            StringViewT name() const { return mName; }
+            StringViewT name() const { return mName.view(); }
+            const json_detail::item_key &key() const { return mName; }
+            void set_name(StringViewT name) { mName.assign(name); }
+            void set_name(json_detail::item_key &&name) { mName = std::move(name); }
             JsonT &value() { return *this; }
             const JsonT &value() const { return *this; }
 
         private:
-            StringT mName;
+            json_detail::item_key mName;
         };
 
-        enum class value_t
+        enum class value_t : uint8_t
         {
             null,
             integer,
@@ -98,18 +376,93 @@ namespace ulib
             array,
             object,
             floating,
-            boolean
+            boolean,
+            unsigned_integer // integers above INT64_MAX
         };
 
         using ThisT = ulib::json;
         using EncodingT = ulib::MultibyteEncoding;
         using CharT = typename EncodingT::CharT;
-        using AllocatorT = ulib::DefaultAllocator;
+        using AllocatorT = ulib::json_allocator;
         using StringT = ulib::EncodedString<EncodingT, AllocatorT>;
         using StringViewT = ulib::EncodedStringView<EncodingT>;
 
         using ItemT = basic_item<ulib::json>;
-        using ObjectT = ulib::List<ItemT, AllocatorT>;
+
+        class object_list;
+
+        // Open addressing table of item positions + 1 by key hash, kept by objects of kIndexThreshold
+        // items or more so lookups don't scan them. It covers the count of items it was built for: an
+        // object resized through the list itself is scanned instead. Items reordered or renamed through
+        // items() keep their count, so that drops the index and the next non-const lookup builds it
+        // again. The table comes from json_allocator like the items, so a document's arena holds it too
+        class object_index
+        {
+        public:
+            object_index() = default;
+            object_index(object_index &&other) noexcept : mTable(other.mTable) { other.mTable = nullptr; }
+            object_index(const object_index &) = delete;
+            ~object_index() { reset(); }
+
+            object_index &operator=(object_index &&other) noexcept
+            {
+                std::swap(mTable, other.mTable);
+                return *this;
+            }
+
+            object_index &operator=(const object_index &) = delete;
+
+            bool covers(size_t size) const { return mTable && mTable[0] == size; }
+            void reset();
+            void build(const object_list &items);
+            // items.back() was appended
+            void insert(const object_list &items);
+            // items.size() if there is none
+            size_t find(const object_list &items, StringViewT name) const;
+
+        private:
+            size_t probe(const object_list &items, StringViewT name) const;
+
+            // the covered count and the mask precede the slots
+            uint32_t *mTable = nullptr;
+        };
+
+        static constexpr size_t kIndexThreshold = 32;
+
+        // the items of an object in insertion order, and their index once there are enough of them
+        class object_list : public ulib::List<ItemT, AllocatorT>
+        {
+        public:
+            using ListT = ulib::List<ItemT, AllocatorT>;
+
+            object_list() = default;
+            object_list(const object_list &other) : ListT(other) { reindex(); }
+            object_list(object_list &&other) noexcept = default;
+
+            object_list &operator=(const object_list &other)
+            {
+                ListT::operator=(other);
+                reindex();
+                return *this;
+            }
+
+            object_list &operator=(object_list &&other) noexcept = default;
+
+            // position of the first item named name, size() if there is none
+            size_t find(StringViewT name) const;
+            // keeps the index after an item was appended
+            void appended();
+            // builds the index or drops it, for items changed in place
+            void reindex();
+            void clear_index() { mIndex.reset(); }
+            // builds the index when it doesn't cover the items, const lookups only scan then
+            void restore_index();
+
+        private:
+            object_index mIndex;
+        };
+
+        using ObjectT = object_list;
         using ArrayT = ulib::List<ThisT, AllocatorT>;
 
         using Iterator = ulib::RandomAccessIterator<ThisT>;
@@ -132,6 +485,8 @@ namespace ulib
                 return "integer";
             case value_t::floating:
                 return "floating";
+            case value_t::unsigned_integer:
+                return "unsigned integer";
             case value_t::boolean:
                 return "boolean";
             case value_t::array:
@@ -148,44 +503,468 @@ namespace ulib
         static json object() { return json{value_t::object}; }
         static json array() { return json{value_t::array}; }
 
+        // what the parser does when an object repeats a key
+        enum class duplicate_keys
+        {
+            last_wins,  // first position, last value
+            first_wins, // later members are dropped
+            reject,     // ParseError
+            keep_all    // every member is kept in order
+        };
+
+        // how much the parser checks the text of strings and keys
+        enum class string_validation
+        {
+            strict, // valid UTF-8, only the escapes of the spec, \u surrogates in pairs
+            trusted // input known to be valid: nothing is checked, lone surrogates decode to U+FFFD
+        };
+
+        // how the parser stores numbers
+        enum class number_mode
+        {
+            decode, // converted to int64, uint64 or double while parsing
+            lazy    // the text is kept and converted by get<T>(), dump() writes it back unchanged
+        };
+
+        // errors of the non throwing api: parsing and lookups
+        enum class errc : uint8_t
+        {
+            ok,
+            unexpected_end,
+            unexpected_character,
+            invalid_value,
+            invalid_number,
+            invalid_literal,
+            invalid_utf8,
+            invalid_escape,
+            duplicate_key,
+            depth_exceeded,
+            not_an_object,
+            not_an_array,
+            key_not_found,
+            index_out_of_range,
+            wrong_type
+        };
+
+        static StringViewT errc_to_string(errc e)
+        {
+            switch (e)
+            {
+            case errc::ok:
+                return "ok";
+            case errc::unexpected_end:
+                return "Unexpected end of file";
+            case errc::unexpected_character:
+                return "Unexpected character";
+            case errc::invalid_value:
+                return "json invalid value type";
+            case errc::invalid_number:
+                return "Invalid number";
+            case errc::invalid_literal:
+                return "Invalid constant";
+            case errc::invalid_utf8:
+                return "Invalid UTF-8";
+            case errc::invalid_escape:
+                return "Invalid escape sequence";
+            case errc::duplicate_key:
+                return "Duplicate key";
+            case errc::depth_exceeded:
+                return "Maximum nesting depth exceeded";
+            case errc::not_an_object:
+                return "json must be an object";
+            case errc::not_an_array:
+                return "json must be an array";
+            case errc::key_not_found:
+                return "key not found";
+            case errc::index_out_of_range:
+                return "index out of range";
+            case errc::wrong_type:
+                return "json invalid get() type";
+            }
+
+            return "unknown";
+        }
+
+        // outcome of parser::try_parse: the first error and its byte offset in the input
+        struct parse_status
+        {
+            errc error = errc::ok;
+            size_t offset = 0;
+
+            explicit operator bool() const { return error == errc::ok; }
+        };
+
+        template <class T>
+        class result;
+
+        struct parse_options
+        {
+            duplicate_keys duplicates = duplicate_keys::last_wins;
+
+            // strings and keys without escapes point into the input instead of being copied,
+            // the input must outlive the parsed tree. Copies of the tree own their strings.
+            bool in_situ = false;
+
+            // containers nested deeper than this fail with errc::depth_exceeded
+            size_t max_depth = 1024;
+
+            // parse(str, out) overwrites out in place: arrays, objects and strings that are already
+            // there keep their storage, so parsing the same shape again doesn't allocate
+            bool reuse_storage = false;
+
+            string_validation strings = string_validation::strict;
+
+            // number_mode::lazy keeps the text of numbers instead of converting it. Text that doesn't fit
+            // in the node is borrowed from the input when in_situ is set and copied otherwise.
+            // Integers of more than 18 digits are converted while parsing to know if they fit int64
+            number_mode numbers = number_mode::decode;
+
+            // keys are interned here instead of being copied into every object, the pool can be
+            // shared by parsers on several threads and must outlive the trees
+            key_pool *keys = nullptr;
+        };
+
+        struct ndjson_options
+        {
+            // 0: one per hardware thread
+            size_t threads = 0;
+            // lines are handed to workers in chunks of about this many bytes
+            size_t chunk_size = 1024 * 1024;
+            parse_options parse;
+        };
+
+        class push_parser;
+        class path_set;
+        class lazy_value;
+        class lazy_document;
+        class tape_document;
+        class ndjson_reader;
+
         class parser
         {
         public:
+            parser() = default;
+            parser(const parse_options &options) : mOptions(options) {}
+
+            // buffers are kept across parses, a long lived parser only allocates while they grow
+            void set_options(const parse_options &options) { mOptions = options; }
+            // frees the buffers a large document grew past 64 KiB: escaped strings, key tables
+            // of large objects and the container stack of deep documents
+            void trim_buffers();
+
             json parse(ulib::string_view str);
             void parse(ulib::string_view str, json &out);
+            // never throws on malformed input, out is left partially filled then
+            parse_status try_parse(ulib::string_view str, json &out);
+            parse_status status() const;
+            // formatted on request: "<error> at line:column"
+            ulib::string error_message();
+            // maps the file instead of reading it, in_situ is ignored since the mapping ends with the call
+            json parse_file(const std::filesystem::path &path);
+            // Parses a top level array on threads workers (0: one per hardware thread). Two parallel passes
+            // resolve the string state and nesting at evenly spaced offsets and find a comma between
+            // elements after each, then every chunk of elements is parsed into a partial array on its
+            // own worker and the elements are moved into the result. Any other document, and one too small
+            // to split, is parsed on the calling thread. Throws ParseError on malformed input
+            json parse_parallel(ulib::string_view str, size_t threads = 0);
             // line, symbol
             std::pair<int, int> error_pos();
 
+            // Reports the document to handler as events instead of building a tree:
+            // start_object(), end_object(), start_array(), end_array(), key(name), string(str),
+            // integer(int64_t), unsigned_integer(uint64_t), floating(double), boolean(bool), null().
+            // Each returns false to stop parsing, sax_parse then returns false. Views are only valid
+            // during the call, keys are reported as they appear regardless of the duplicate policy
+            template <class HandlerT>
+            bool sax_parse(ulib::string_view str, HandlerT &handler)
+            {
+                set_str(str);
+                advance();
+
+                bool completed = sax_value(handler, 0);
+                if (mError != errc::ok)
+                    throw ParseError{ulib::string{errc_to_string(mError)}};
+
+                return completed;
+            }
+
+            // Offset of the first token after the value starting at offset (whitespace before it is
+            // skipped), str.size() when there is none. The value isn't built: a container is passed
+            // over by a SIMD bracket balancing scan that validates nothing inside it.
+            // Throws ParseError when the container isn't closed
+            size_t skip(ulib::string_view str, size_t offset = 0);
+
+            // Materializes only the values at paths, calling callback(pointer index, value) for each in
+            // document order, it returns false to stop. Subtrees no pointer leads into are passed over by
+            // bracket balancing, so they are never built and their scalars aren't validated.
+            // Returns the number of values delivered, throws ParseError on malformed input
+            size_t select(ulib::string_view str, const path_set &paths,
+                          const std::function<bool(size_t, json &)> &callback);
+
+            // Writes the document straight into out without building a tree: a struct described
+            // with ULIB_JSON_STRUCT, or any member type json_struct.h reads. Unknown keys are skipped,
+            // members missing from the document keep their values. Needs json_struct.h
+            template <class T>
+            void parse_into(ulib::string_view str, T &out)
+            {
+                if (!try_parse_into(str, out))
+                    throw ParseError{ulib::string{errc_to_string(mError)}};
+            }
+
+            template <class T>
+            parse_status try_parse_into(ulib::string_view str, T &out)
+            {
+                set_str(str);
+                advance();
+                json_detail::value_reader<T>::read(*this, out, 0);
+                return status();
+            }
+
         private:
-            void skip_spaces();
-            void step();
-            bool step_check_eof();
+            template <class HandlerT>
+            bool sax_value(HandlerT &handler, size_t depth)
+            {
+                switch (token())
+                {
+                case '{':
+                case '[':
+                    if (depth == mOptions.max_depth)
+                        return fail(errc::depth_exceeded, mIt);
+
+                    return *mIt == '{' ? sax_object(handler, depth + 1) : sax_array(handler, depth + 1);
+                case '\"': {
+                    mIt++;
+                    StringViewT str;
+                    bool escaped;
+                    if (!parse_quote_end_string(str, escaped))
+                        return false;
+
+                    bool result = handler.string(str);
+                    advance();
+                    return result;
+                }
+                case 't':
+                case 'f': {
+                    bool value;
+                    return scan_boolean(value) && handler.boolean(value);
+                }
+                case 'n':
+                    return scan_null() && handler.null();
+                case '-':
+                case '0':
+                case '1':
+                case '2':
+                case '3':
+                case '4':
+                case '5':
+                case '6':
+                case '7':
+                case '8':
+                case '9':
+                    break;
+                default:
+                    return fail(mIt == mEnd ? errc::unexpected_end : errc::invalid_value, mIt);
+                }
 
-            value_t pending_value();
+                json_detail::number num;
+                if (!scan_number(num))
+                    return false;
 
-            void parse_value(value_t vt, json *out);
+                switch (num.kind)
+                {
+                case json_detail::number_kind::integer:
+                    return handler.integer(num.i);
+                case json_detail::number_kind::unsigned_integer:
+                    return handler.unsigned_integer(num.u);
+                default:
+                    return handler.floating(num.d);
+                }
+            }
 
-            void parse_object(json *out);
-            void parse_array(json *out);
-            void parse_string(json *out);
-            void parse_integer(json *out);
-            void parse_boolean(json *out);
-            void parse_null(json *out);
+            template <class HandlerT>
+            bool sax_object(HandlerT &handler, size_t depth)
+            {
+                if (!handler.start_object())
+                    return false;
+
+                advance(); // '{'
+                if (token() == '}')
+                {
+                    advance();
+                    return handler.end_object();
+                }
 
-            void step_through(char c);
+                while (true)
+                {
+                    if (token() != '\"')
+                        return unexpected();
+
+                    mIt++;
+                    StringViewT name;
+                    bool escaped;
+                    if (!parse_quote_end_string(name, escaped) || !handler.key(name))
+                        return false;
+
+                    advance();
+                    if (token() != ':')
+                        return unexpected();
+
+                    advance();
+                    if (!sax_value(handler, depth))
+                        return false;
+
+                    if (token() == ',')
+                    {
+                        advance();
+                    }
+                    else if (token() == '}')
+                    {
+                        advance();
+                        return handler.end_object();
+                    }
+                    else
+                    {
+                        return unexpected();
+                    }
+                }
+            }
 
-            size_t quote_end_string_size();
-            StringT parse_quote_end_string();
+            template <class HandlerT>
+            bool sax_array(HandlerT &handler, size_t depth)
+            {
+                if (!handler.start_array())
+                    return false;
 
-            void pending_object();
+                advance(); // '['
+                if (token() == ']')
+                {
+                    advance();
+                    return handler.end_array();
+                }
+
+                while (true)
+                {
+                    if (!sax_value(handler, depth))
+                        return false;
+
+                    if (token() == ',')
+                    {
+                        advance();
+                    }
+                    else if (token() == ']')
+                    {
+                        advance();
+                        return handler.end_array();
+                    }
+                    else
+                    {
+                        return unexpected();
+                    }
+                }
+            }
+
+            // stage 1: moves mIt to the next structural character, mEnd if none left
+            void advance();
+            bool index_window();
+            char token() const { return mIt != mEnd ? *mIt : '\0'; }
+
+            // records the first error, always returns false
+            bool fail(errc code, const char *at);
+            bool unexpected();
+            // the value at mIt can't be read into the requested type
+            bool wrong_type();
+            bool finish_atom();
+
+            struct frame
+            {
+                json *value;
+                // children parsed so far, the ones after it are left from a reused tree
+                size_t count;
+            };
+
+            // every parse step returns false once an error was recorded
+            bool parse_value(json *out);
+            // the place of the next child of parent, reused when there is one left
+            json *next_child(frame &parent);
+            bool close_container(frame &container);
+            // '"name":' of the item index of object, returns the place of its value or nullptr on error
+            json *parse_key(json *object, size_t index);
+            // pooled with mOptions.keys, borrowed in situ, otherwise owned
+            json_detail::item_key make_key(StringViewT name, bool escaped);
+
+            bool parse_string(json *out);
+            bool parse_number(json *out);
+            bool parse_boolean(json *out);
+            bool parse_null(json *out);
+
+            bool scan_number(json_detail::number &num);
+            bool scan_boolean(bool &value);
+            bool scan_null();
+
+            // on demand access, positions are structural characters of the input.
+            // seek() continues tokenizing from pos, reusing the index when pos is in the current window
+            void seek(const char *pos);
+            // moves past the value at mIt by balancing brackets, on the index and then with
+            // find_container_end past it, nothing inside is validated
+            bool skip_value();
+            // the value of the first item named name / of the element idx,
+            // nullptr if there is none or on error
+            const char *find_field(const char *object, StringViewT name);
+            const char *find_element(const char *array, size_t idx);
+
+            bool parse_quote_end_string(StringViewT &result, bool &escaped);
+            bool decode_unicode_escape(const char *escape, const char *&it, size_t &size);
+            // strict strings: the first malformed UTF-8 sequence in [p, end) is an error
+            bool check_utf8(const char *p, const char *end);
+
+            bool resolve_duplicates(json *out, const char *close);
+
+            // the elements in chunk of a top level array split by parse_parallel,
+            // the first chunk starts after the opening bracket and the last one holds the closing one
+            bool parse_elements(ulib::string_view chunk, bool first, bool last, ArrayT &out);
+
+            // the value at mIt is reached in state of paths, false on error or when callback stopped
+            bool select_value(const path_set &paths, uint32_t state,
+                              const std::function<bool(size_t, json &)> &callback, size_t &delivered);
 
             void set_str(ulib::string_view str);
 
+            parse_options mOptions;
+
             const char *mIt;
             const char *mBegin;
             const char *mEnd;
+
+            // structural positions of the current window, relative to mWindow
+            ulib::List<uint32_t> mStructurals;
+            size_t mStructuralsCount = 0;
+            size_t mNextStructural = 0;
+            const char *mWindow;
+            const char *mIndexed;
+            json_detail::scanner_state mScanner;
+
+            // open addressing table of item indices, only used while an object is closed
+            ulib::List<uint32_t> mKeyTable;
+
+            // strings with escapes are decoded here, grows on demand
+            ulib::List<char> mEscapeBuffer;
+
+            // containers opened by parse_value, grows on demand up to mOptions.max_depth
+            ulib::List<frame> mStack;
+
+            errc mError = errc::ok;
+            const char *mErrorAt = nullptr;
+
+            friend class json::push_parser;
+            friend class json::lazy_value;
+            friend class json::lazy_document;
+            friend class json::ndjson_reader;
+            template <class T, class>
+            friend struct json_detail::value_reader;
         };
 
+        class document;
+
         struct vtable
         {
             size_t (*size)(json *t);
@@ -197,15 +976,27 @@ namespace ulib
             // TODO: more
         };
 
-        static json parse(StringViewT str)
+        // both use a parser kept per thread, which calls trim_buffers() after every parse
+        static json parse(StringViewT str);
+        static json parse(StringViewT str, const parse_options &options);
+
+        static json parse_file(const std::filesystem::path &path)
         {
             parser prsr;
-            return prsr.parse(str);
+            return prsr.parse_file(path);
         }
 
+        static json parse_file(const std::filesystem::path &path, const parse_options &options)
+        {
+            parser prsr{options};
+            return prsr.parse_file(path);
+        }
+
+        static lazy_document parse_lazy(StringViewT str);
+
         json() : mType(value_t::null) {}
         json(const json &v);
-        json(json &&v);
+        json(json &&v) noexcept;
 
         json(value_t t);
 
@@ -222,15 +1013,23 @@ namespace ulib
         }
 
         template <class T, std::enable_if_t<std::is_floating_point_v<T>, bool> = true>
-        json(T v) : mType(value_t::floating), mFloatVal(float(v))
+        json(T v) : mType(value_t::floating), mFloatVal(double(v))
         {
         }
 
-        template <class T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, bool> = true>
+        template <class T, std::enable_if_t<std::is_integral_v<T> && std::is_signed_v<T>, bool> = true>
         json(T v) : mType(value_t::integer), mIntVal(int64_t(v))
         {
         }
 
+        template <class T,
+                  std::enable_if_t<std::is_integral_v<T> && std::is_unsigned_v<T> && !std::is_same_v<T, bool>, bool> = true>
+        json(T v)
+            : mType(uint64_t(v) > uint64_t(INT64_MAX) ? value_t::unsigned_integer : value_t::integer),
+              mUIntVal(uint64_t(v))
+        {
+        }
+
         template <class T, std::enable_if_t<std::is_same_v<T, bool>, bool> = true>
         json(T v) : mType(value_t::boolean), mBoolVal(v)
         {
@@ -260,7 +1059,7 @@ namespace ulib
         template <class T, std::enable_if_t<std::is_floating_point_v<T>, bool> = true>
         void assign(T v)
         {
-            implicit_set_float(float(v));
+            implicit_set_float(double(v));
         }
 
         template <class T, std::enable_if_t<std::is_same_v<T, bool>, bool> = true>
@@ -269,19 +1068,31 @@ namespace ulib
             implicit_set_boolean(int64_t(v));
         }
 
-        template <class T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, bool> = true>
+        template <class T, std::enable_if_t<std::is_integral_v<T> && std::is_signed_v<T>, bool> = true>
         void assign(T v)
         {
             implicit_set_integer(int64_t(v));
         }
 
+        template <class T,
+                  std::enable_if_t<std::is_integral_v<T> && std::is_unsigned_v<T> && !std::is_same_v<T, bool>, bool> = true>
+        void assign(T v)
+        {
+            implicit_set_unsigned(uint64_t(v));
+        }
+
         template <class T, std::enable_if_t<std::is_floating_point_v<T>, bool> = true>
         T get() const
         {
-            if (mType == value_t::floating)
+            // the flags of numbers are empty unless their text is kept
+            if (mType == value_t::floating && !mFlags)
                 return T(mFloatVal);
-            if (mType == value_t::integer)
+            if (mType == value_t::integer && !mFlags)
                 return T(mIntVal);
+            if (mType == value_t::unsigned_integer && !mFlags)
+                return T(mUIntVal);
+            if (mFlags & kNumberText)
+                return decode_number().as<T>();
 
             throw json::exception(ulib::string{"json invalid get() type. expected: floating or integer. current: "} +
                                   type_to_string(mType));
@@ -300,10 +1111,14 @@ namespace ulib
         template <class T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, bool> = true>
         T get() const
         {
-            if (mType == value_t::integer)
-                return T(mIntVal);
-            if (mType == value_t::floating)
+            if (mType == value_t::integer && !mFlags)
                 return T(mIntVal);
+            if (mType == value_t::unsigned_integer && !mFlags)
+                return T(mUIntVal);
+            if (mType == value_t::floating && !mFlags)
+                return T(mFloatVal);
+            if (mFlags & kNumberText)
+                return decode_number().as<T>();
 
             throw json::exception(ulib::string{"json invalid get() type. expected: integer or floating. current: "} +
                                   type_to_string(mType));
@@ -314,7 +1129,7 @@ namespace ulib
         T get() const
         {
             if (mType == value_t::string)
-                return ulib::Convert<TEncodingT>(ulib::u8(mString));
+                return ulib::Convert<TEncodingT>(ulib::u8(string_ref()));
 
             throw json::exception(ulib::string{"json invalid get() type. expected: string. current: "} +
                                   type_to_string(mType));
@@ -326,7 +1141,7 @@ namespace ulib
         T get() const
         {
             if (mType == value_t::string)
-                return ulib::string_view{mString.raw_data(), mString.size()};
+                return string_ref();
 
             throw json::exception(ulib::string{"json invalid get() type. expected: string. current: "} +
                                   type_to_string(mType));
@@ -336,7 +1151,7 @@ namespace ulib
         T get() const
         {
             if (mType == value_t::string)
-                return ulib::string_view{mString.raw_data(), mString.size()};
+                return string_ref();
 
             throw json::exception(ulib::string{"json invalid get() type. expected: string. current: "} +
                                   type_to_string(mType));
@@ -379,7 +1194,7 @@ namespace ulib
             if (right)
                 assign(*right);
             else
-                mType = value_t::null;
+                implicit_set_type(value_t::null);
         }
 
         template <class T>
@@ -416,17 +1231,39 @@ namespace ulib
         const_reference operator[](StringViewT key) const { return at(key); }
         const_reference operator[](size_t idx) const { return at(idx); }
 
-        span<const ItemT> items() const { return implicit_const_touch_object(), mObject; }
-        span<ItemT> items() { return implicit_touch_object(), mObject; }
+        span<const ItemT> items() const { return implicit_const_touch_object(), *mObject; }
+        // the items may be reordered or renamed through the span, so the key index is dropped
+        span<ItemT> items()
+        {
+            implicit_touch_object();
+            mObject->clear_index();
+            return *mObject;
+        }
+
+        span<const json> values() const { return implicit_const_touch_array(), *mArray; }
+        span<json> values() { return implicit_touch_array(), *mArray; }
 
-        span<const json> values() const { return implicit_const_touch_array(), mArray; }
-        span<json> values() { return implicit_touch_array(), mArray; }
+        iterator begin() { return implicit_const_touch_array(), mArray->begin(); }
+        const_iterator begin() const { return implicit_const_touch_array(), mArray->begin(); }
 
-        iterator begin() { return implicit_const_touch_array(), mArray.begin(); }
-        const_iterator begin() const { return implicit_const_touch_array(), mArray.begin(); }
+        iterator end() { return implicit_const_touch_array(), mArray->end(); }
+        const_iterator end() const { return implicit_const_touch_array(), mArray->end(); }
 
-        iterator end() { return implicit_const_touch_array(), mArray.end(); }
-        const_iterator end() const { return implicit_const_touch_array(), mArray.end(); }
+        // lookups reporting errors as codes instead of exceptions
+        result<const json &> find(StringViewT name) const;
+        result<json &> find(StringViewT name);
+        result<const json &> find(size_t idx) const;
+        result<json &> find(size_t idx);
+
+        // get<T>() reporting wrong_type instead of throwing, unlike try_get() null is an error too
+        template <class T>
+        result<T> get_result() const
+        {
+            if (!holds<T>())
+                return errc::wrong_type;
+
+            return get<T>();
+        }
 
         const json *search(StringViewT name) const
         {
@@ -450,6 +1287,9 @@ namespace ulib
         reference push_back();
         value_t type() const { return mType; }
 
+        // the text of a number parsed with number_mode::lazy, empty for other values and once it was assigned
+        StringViewT number_text() const { return mFlags & kNumberText ? string_ref() : StringViewT{}; }
+
         template <class TStringT = ulib::string, class TEncodingT = string_encoding_t<TStringT>,
                   std::enable_if_t<!std::is_same_v<TEncodingT, missing_type> && is_string_v<TStringT>, bool> = true>
         TStringT dump() const
@@ -466,26 +1306,30 @@ namespace ulib
                 throw json::exception(ulib::string{"failed to remove key: \""} + key +
                                       "\" json value must be an object. current: " + type_to_string(mType));
 
-            for (auto it = mObject.begin(); it != mObject.end(); it++)
-            {
-                if (it->name() == key)
-                {
-                    mObject.erase(it);
-                    return;
-                }
-            }
+            size_t pos = mObject->find(key);
+            if (pos == mObject->size())
+                return;
+
+            mObject->erase(mObject->begin() + pos);
+            mObject->reindex();
         }
 
-        inline bool is_int() const { return mType == value_t::integer; }
+        inline bool is_int() const { return mType == value_t::integer || mType == value_t::unsigned_integer; }
         inline bool is_float() const { return mType == value_t::floating; }
         inline bool is_string() const { return mType == value_t::string; }
         inline bool is_array() const { return mType == value_t::array; }
         inline bool is_object() const { return mType == value_t::object; }
-        inline bool is_number() const { return mType == value_t::integer || mType == value_t::floating; }
+        inline bool is_number() const
+        {
+            return mType == value_t::integer || mType == value_t::unsigned_integer || mType == value_t::floating;
+        }
         inline bool is_bool() const { return mType == value_t::boolean; }
         inline bool is_null() const { return mType == value_t::null; }
 
     private:
+        // json_view::value() appends the members of a resolved object without looking them up
+        friend class json_view;
+
         void initialize_as_string();
         void initialize_as_object();
         void initialize_as_array();
@@ -501,8 +1345,9 @@ namespace ulib
         void implicit_set_type(value_t t);
         void implicit_set_string(StringViewT other);
         void implicit_move_set_string(StringT &&other);
-        void implicit_set_float(float other);
+        void implicit_set_float(double other);
         void implicit_set_integer(int64_t other);
+        void implicit_set_unsigned(uint64_t other);
         void implicit_set_boolean(bool other);
 
         void construct_from_type(value_t t);
@@ -515,23 +1360,563 @@ namespace ulib
 
         void destroy_containers();
 
+        // appends without looking for an existing key, used by the parser which indexes the object once closed
+        reference append_item(json_detail::item_key &&name) { return mObject->emplace_back(std::move(name)).value(); }
+
+        // in situ string, str must outlive the value
+        void set_borrowed_string(StringViewT str);
+
+        StringViewT string_ref() const
+        {
+            if (mFlags & kInlineString)
+                return StringViewT{inline_chars(), size_t(mFlags >> kInlineSizeShift)};
+
+            return StringViewT{mChars, size_t(mSize)};
+        }
+
+        // a string owned by the node, stored inline when it fits
+        void set_chars(StringViewT str);
+        void release_chars();
+
+        // type: the numeric type get<T>() converts from, borrow: text that doesn't fit inline may point into the input
+        void set_number_text(StringViewT text, value_t type, bool borrow);
+        // noexcept, so loops calling get<T>() keep their registers across it
+        json_detail::number decode_number() const noexcept;
+
+        // the type of a checked number, integers of more than 18 digits are converted to tell it
+        static value_t lazy_number_type(StringViewT text, size_t int_digits, bool integral);
+
+        char *inline_chars() { return reinterpret_cast<char *>(this) + kInlineOffset; }
+        const char *inline_chars() const { return reinterpret_cast<const char *>(this) + kInlineOffset; }
+
         json *find_object_in_object(StringViewT name);
         const json *find_object_in_object(StringViewT name) const;
 
+        // whether get<T>() accepts the current type
+        template <class T>
+        bool holds() const
+        {
+            if constexpr (std::is_same_v<T, bool>)
+                return mType == value_t::boolean;
+            else if constexpr (std::is_arithmetic_v<T>)
+                return is_number();
+            else
+                return mType == value_t::string;
+        }
+
+        static constexpr uint8_t kBorrowedString = 1; // mChars points into the parsed input
+        static constexpr uint8_t kInlineString = 2;   // the text is stored in the node
+        static constexpr uint8_t kNumberText = 4;     // a number kept as text, stored like a string
+        static constexpr uint8_t kInlineSizeShift = 4;
+
+        static constexpr size_t kInlineOffset = 2;
+        static constexpr size_t kInlineCapacity = 14;
+
+        // A node is 16 bytes. Numbers and the pointers to containers and string text take the last 8,
+        // the size of a string the 4 before them. Strings of up to kInlineCapacity bytes are stored in
+        // place of all three fields after mFlags instead, their size in the high bits of mFlags.
+        // The text of lazy numbers is stored the same way. Owned text and containers are
+        // allocated with json_allocator
         value_t mType;
+        uint8_t mFlags = 0;
+        char mInlineHead[2] = {};
+        uint32_t mSize = 0;
 
         union {
             bool mBoolVal;
-            float mFloatVal;
+            double mFloatVal;
             int64_t mIntVal;
+            uint64_t mUIntVal;
 
-            StringT mString;
-            ObjectT mObject;
-            ArrayT mArray;
+            const char *mChars;
+            ObjectT *mObject;
+            ArrayT *mArray;
         };
 
         static size_t serialized_length(const json &obj);
         static char *c_serialize(const json &obj, char *_out);
     };
 
+    // Value or error code. The message is only looked up when it is asked for
+    template <class T>
+    class json::result
+    {
+    public:
+        result(T value) : mValue(std::move(value)), mError(errc::ok) {}
+        result(errc error) : mValue(), mError(error) {}
+
+        bool has_value() const { return mError == errc::ok; }
+        explicit operator bool() const { return has_value(); }
+        errc error() const { return mError; }
+        StringViewT message() const { return errc_to_string(mError); }
+
+        // throws json::exception on error
+        const T &value() const
+        {
+            if (!has_value())
+                throw exception{ulib::string{message()}};
+
+            return mValue;
+        }
+
+        T value_or(T other) const { return has_value() ? mValue : std::move(other); }
+
+        const T &operator*() const { return mValue; }
+        const T *operator->() const { return &mValue; }
+
+    private:
+        T mValue;
+        errc mError;
+    };
+
+    template <class T>
+    class json::result<T &>
+    {
+    public:
+        result(T &value) : mValue(&value), mError(errc::ok) {}
+        result(errc error) : mValue(nullptr), mError(error) {}
+
+        bool has_value() const { return mError == errc::ok; }
+        explicit operator bool() const { return has_value(); }
+        errc error() const { return mError; }
+        StringViewT message() const { return errc_to_string(mError); }
+
+        // throws json::exception on error
+        T &value() const
+        {
+            if (!has_value())
+                throw exception{ulib::string{message()}};
+
+            return *mValue;
+        }
+
+        T &operator*() const { return *mValue; }
+        T *operator->() const { return mValue; }
+
+    private:
+        T *mValue;
+        errc mError;
+    };
+
+    // Parser for input that arrives in pieces, e.g. a request body read from a socket.
+    // Nesting and a partially read token are kept between feed() calls, so parsing
+    // overlaps with receiving and the whole document is never buffered.
+    class json::push_parser
+    {
+    public:
+        push_parser() = default;
+        push_parser(const parse_options &options) : mHelper(options) {}
+
+        // consumes the whole chunk, returns true once the value is complete.
+        // Only whitespace may follow a complete value
+        bool feed(ulib::string_view chunk);
+        // end of input: completes a top level number, throws if the value is unfinished
+        void finish();
+
+        bool done() const { return mState == state::done; }
+        // moves out the complete value and resets for the next one
+        json take();
+        void reset();
+
+    private:
+        enum class state : uint8_t
+        {
+            value,
+            first_value,
+            first_key,
+            key,
+            colon,
+            next,
+            string,
+            escape,
+            unicode,
+            literal,
+            number,
+            done
+        };
+
+        const char *consume(const char *p, const char *end);
+        json *slot();
+        void open(value_t type);
+        void close(char bracket);
+        void complete();
+        void complete_string();
+        void complete_unicode();
+        void lone_surrogate();
+        void complete_number();
+        void append_token(const char *p, size_t size);
+
+        // resolves duplicate keys of closed objects
+        parser mHelper;
+
+        json mRoot;
+        ulib::List<json *> mStack;
+        json_detail::item_key mKey;
+
+        state mState = state::value;
+        bool mStringIsKey = false;
+
+        // partial string or number, mTokenSize bytes used
+        ulib::List<char> mToken;
+        size_t mTokenSize = 0;
+
+        const char *mLiteral = nullptr;
+        size_t mLiteralPos = 0;
+
+        // \uXXXX being read, and a high surrogate waiting for its low one
+        uint32_t mUnit = 0;
+        size_t mHexDigits = 0;
+        uint32_t mHighSurrogate = 0;
+    };
+
+    // Owns a monotonic arena that the parser takes every array, object, key and string of
+    // the tree from, so the tree is freed in O(1) with the arena. Reaching the tree through
+    // mutable_root() makes the destructor run node destructors first, which frees whatever was
+    // attached from the heap afterwards. Copy nodes out of a document instead of moving them.
+    class json::document
+    {
+    public:
+        document();
+        document(document &&other);
+        document &operator=(document &&other);
+        ~document();
+
+        void parse(StringViewT str);
+        void parse(StringViewT str, const parse_options &options);
+
+        // the mapping is kept with the tree, so in_situ strings can point into it
+        void parse_file(const std::filesystem::path &path);
+        void parse_file(const std::filesystem::path &path, const parse_options &options);
+
+        const json &root() const { return mRoot; }
+        json &mutable_root() { return mMutated = true, mRoot; }
+
+        const json &operator[](StringViewT key) const { return mRoot[key]; }
+        const json &operator[](size_t idx) const { return mRoot[idx]; }
+
+        // bytes reserved by the arena
+        size_t capacity() const { return mArena->capacity(); }
+
+    private:
+        void reset();
+
+        std::unique_ptr<json_detail::monotonic_arena> mArena;
+        std::unique_ptr<json_detail::mapped_file> mFile;
+        union {
+            json mRoot;
+        };
+        bool mMutated;
+    };
+
+    // A value of a lazy_document: only its position in the input. Nothing is parsed until
+    // a field, element or scalar is asked for, and values passed over on the way are skipped
+    // without being materialized. Valid while its document and the input are alive.
+    class json::lazy_value
+    {
+    public:
+        // first item with this name, throws json::exception if there is none
+        lazy_value operator[](StringViewT name) const;
+        lazy_value operator[](size_t idx) const;
+
+        std::optional<lazy_value> find(StringViewT name) const;
+
+        value_t type() const;
+
+        // materializes the value and its subtree
+        json value() const;
+
+        // views are valid until the next access to the document
+        template <class T>
+        T get() const
+        {
+            if constexpr (std::is_same_v<T, StringViewT>)
+                return string_view();
+            else
+                return value().get<T>();
+        }
+
+    private:
+        friend class lazy_document;
+
+        lazy_value(parser *prsr, const char *pos) : mParser(prsr), mPos(pos) {}
+
+        StringViewT string_view() const;
+
+        parser *mParser;
+        const char *mPos;
+    };
+
+    // Pull style access to a document: doc["user"]["id"].get<int64_t>() reads only what is on
+    // the way to the value. The input is not copied and must outlive the document.
+    class json::lazy_document
+    {
+    public:
+        lazy_document(StringViewT str);
+
+        lazy_value root() const { return lazy_value{mParser.get(), mRoot}; }
+
+        lazy_value operator[](StringViewT name) const { return root()[name]; }
+        lazy_value operator[](size_t idx) const { return root()[idx]; }
+
+    private:
+        std::unique_ptr<parser> mParser;
+        const char *mRoot;
+    };
+
+    inline json::lazy_document json::parse_lazy(StringViewT str) { return lazy_document{str}; }
+
+    class json_view;
+
+    // A read only document in two buffers: the parser writes a tape of 64 bit words (json_tape.h)
+    // and the text of strings and keys, instead of a tree of nodes. Containers store the index
+    // after their end, so readers step over a subtree in O(1). Both buffers are kept across parses.
+    // Numbers are always converted. Repeated keys are resolved like the tree parser does when their
+    // object closes, keep_all leaves them all and lookups find the first. Views are valid until the
+    // next parse
+    class json::tape_document
+    {
+    public:
+        tape_document() = default;
+
+        void parse(StringViewT str);
+        void parse(StringViewT str, const parse_options &options);
+        // strings are copied to the tape's buffer, so the mapping ends with the call
+        void parse_file(const std::filesystem::path &path);
+        void parse_file(const std::filesystem::path &path, const parse_options &options);
+
+        // throws json::exception before the first successful parse
+        json_view root() const;
+
+        json_view operator[](StringViewT name) const;
+        json_view operator[](size_t idx) const;
+
+        // words and string bytes in use
+        size_t tape_size() const { return mTapeSize; }
+        size_t strings_size() const { return mStringsSize; }
+
+    private:
+        struct builder;
+
+        ulib::List<uint64_t> mTape;
+        size_t mTapeSize = 0;
+        ulib::List<char> mStrings;
+        size_t mStringsSize = 0;
+    };
+
+    // A value on the tape of a tape_document: two pointers and an index, copied freely.
+    // Lookups and element access walk the container by its skip offsets
+    class json_view
+    {
+    public:
+        using StringViewT = json::StringViewT;
+        using value_t = json::value_t;
+
+        class item;
+        class value_iterator;
+        class item_iterator;
+
+        template <class IteratorT>
+        class range
+        {
+        public:
+            range(IteratorT b, IteratorT e) : mBegin(b), mEnd(e) {}
+
+            IteratorT begin() const { return mBegin; }
+            IteratorT end() const { return mEnd; }
+
+        private:
+            IteratorT mBegin;
+            IteratorT mEnd;
+        };
+
+        value_t type() const;
+        bool is_object() const { return tag() == '{'; }
+        bool is_array() const { return tag() == '['; }
+        bool is_string() const { return tag() == '\"'; }
+        bool is_null() const { return tag() == 'n'; }
+
+        // first member with this name, throws json::exception if there is none
+        json_view operator[](StringViewT name) const;
+        json_view operator[](size_t idx) const;
+        std::optional<json_view> find(StringViewT name) const;
+
+        // members of an object and elements of an array, json::exception for other values
+        range<item_iterator> items() const;
+        range<value_iterator> values() const;
+        // members or elements, counted on the tape unless there are more than kTapeCountLimit
+        size_t size() const;
+
+        // arithmetic types, bool and StringViewT are read from the tape, other types through value()
+        template <class T>
+        T get() const
+        {
+            uint64_t word = mTape[mIndex];
+            char tag = json_detail::tape_tag(word);
+
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                if (tag == 't' || tag == 'f')
+                    return tag == 't';
+            }
+            else if constexpr (std::is_arithmetic_v<T>)
+            {
+                if (tag == 'd')
+                    return T(json_detail::tape_double(mTape[mIndex + 1]));
+                if (tag == 'l')
+                    return T(int64_t(mTape[mIndex + 1]));
+                if (tag == 'u')
+                    return T(mTape[mIndex + 1]);
+            }
+            else if constexpr (std::is_same_v<T, StringViewT>)
+            {
+                if (tag == '\"')
+                    return string_at(word);
+            }
+            else
+            {
+                return value().get<T>();
+            }
+
+            throw json::exception(ulib::string{"json_view invalid get() type. current: "} +
+                                  json::type_to_string(type()));
+        }
+
+        // materializes the value and its subtree
+        json value() const;
+
+    private:
+        friend class json::tape_document;
+
+        json_view(const uint64_t *tape, const char *strings, size_t index)
+            : mTape(tape), mStrings(strings), mIndex(index)
+        {
+        }
+
+        char tag() const { return json_detail::tape_tag(mTape[mIndex]); }
+        StringViewT string_at(uint64_t word) const
+        {
+            const char *p = mStrings + json_detail::tape_payload(word);
+            uint32_t size;
+            memcpy(&size, p, sizeof(size));
+            return StringViewT{p + sizeof(size), size_t(size)};
+        }
+
+        const uint64_t *mTape;
+        const char *mStrings;
+        size_t mIndex;
+    };
+
+    // a member of an object on the tape: the key word and the value after it
+    class json_view::item
+    {
+    public:
+        StringViewT name() const { return mKey.string_at(mKey.mTape[mKey.mIndex]); }
+        json_view value() const { return json_view{mKey.mTape, mKey.mStrings, mKey.mIndex + 1}; }
+
+    private:
+        friend class json_view;
+        friend class item_iterator;
+
+        item(json_view key) : mKey(key) {}
+
+        json_view mKey;
+    };
+
+    class json_view::value_iterator
+    {
+    public:
+        const json_view &operator*() const { return mValue; }
+        const json_view *operator->() const { return &mValue; }
+
+        value_iterator &operator++()
+        {
+            mValue.mIndex = json_detail::tape_next(mValue.mTape, mValue.mIndex);
+            return *this;
+        }
+
+        bool operator==(const value_iterator &other) const { return mValue.mIndex == other.mValue.mIndex; }
+        bool operator!=(const value_iterator &other) const { return mValue.mIndex != other.mValue.mIndex; }
+
+    private:
+        friend class json_view;
+
+        value_iterator(json_view value) : mValue(value) {}
+
+        json_view mValue;
+    };
+
+    class json_view::item_iterator
+    {
+    public:
+        const item &operator*() const { return mItem; }
+        const item *operator->() const { return &mItem; }
+
+        item_iterator &operator++()
+        {
+            json_view &key = mItem.mKey;
+            key.mIndex = json_detail::tape_next(key.mTape, key.mIndex + 1);
+            return *this;
+        }
+
+        bool operator==(const item_iterator &other) const { return mItem.mKey.mIndex == other.mItem.mKey.mIndex; }
+        bool operator!=(const item_iterator &other) const { return mItem.mKey.mIndex != other.mItem.mKey.mIndex; }
+
+    private:
+        friend class json_view;
+
+        item_iterator(json_view key) : mItem(key) {}
+
+        item mItem;
+    };
+
+    // JSON Pointers (RFC 6901) for parser::select, a "*" token matches any key or index.
+    // The pointers are compiled together into one automaton, so however many of them share a
+    // prefix, every key of the document is looked up once
+    class json::path_set
+    {
+    public:
+        path_set();
+        path_set(std::initializer_list<StringViewT> pointers);
+        path_set(path_set &&other);
+        path_set &operator=(path_set &&other);
+        ~path_set();
+
+        // returns the index callbacks receive for pointer, throws json::exception if it is malformed
+        size_t add(StringViewT pointer);
+        size_t size() const;
+
+    private:
+        friend class parser;
+
+        struct automaton;
+
+        std::unique_ptr<automaton> mAutomaton;
+    };
+
+    // Parses newline delimited json (one value per line, blank lines are skipped) on a pool of
+    // worker threads. Line aligned chunks are distributed over per worker queues that idle workers
+    // steal from, and the values come back on the calling thread in input order. Workers and their
+    // parsers are kept for the lifetime of the reader.
+    class json::ndjson_reader
+    {
+    public:
+        ndjson_reader(const ndjson_options &options = {});
+        ndjson_reader(const ndjson_reader &) = delete;
+        ndjson_reader &operator=(const ndjson_reader &) = delete;
+        ~ndjson_reader();
+
+        // Calls callback for every value in order, it may move the value out and returns false to
+        // stop. A malformed line throws ParseError after the values before it were delivered.
+        // Returns the number of values delivered
+        size_t read(StringViewT buffer, const std::function<bool(json &)> &callback);
+
+    private:
+        struct pool;
+        struct chunk;
+
+        static void parse_chunk(parser &prsr, chunk &out);
+
+        std::unique_ptr<pool> mPool;
+    };
+
 } // namespace ulib
\ No newline at end of file
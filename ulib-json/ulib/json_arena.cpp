@@ -0,0 +1,147 @@
+#include "json_arena.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace ulib
+{
+    namespace json_detail
+    {
+        constexpr size_t kArenaAlignment = 16;
+        constexpr size_t kMaxBlockSize = 64 * 1024 * 1024;
+
+        static thread_local monotonic_arena *tActiveArena = nullptr;
+
+        static size_t align_up(size_t size) { return (size + kArenaAlignment - 1) & ~(kArenaAlignment - 1); }
+
+        monotonic_arena::monotonic_arena(size_t first_block_size)
+            : mHead(nullptr), mCur(nullptr), mEnd(nullptr), mNextSize(first_block_size), mCapacity(0)
+        {
+        }
+
+        monotonic_arena::~monotonic_arena() { release(); }
+
+        void *monotonic_arena::allocate(size_t size)
+        {
+            size = align_up(size);
+            if (size_t(mEnd - mCur) >= size)
+            {
+                void *ptr = mCur;
+                mCur += size;
+                return ptr;
+            }
+
+            return allocate_slow(size);
+        }
+
+        void *monotonic_arena::allocate_slow(size_t size)
+        {
+            size_t block_size = mNextSize;
+            while (block_size < size + sizeof(block) + kArenaAlignment)
+                block_size *= 2;
+
+            block *blk = (block *)malloc(block_size);
+            if (!blk)
+                throw std::bad_alloc{};
+
+            blk->prev = mHead;
+            blk->size = block_size;
+            mHead = blk;
+            mCapacity += block_size;
+
+            if (mNextSize < kMaxBlockSize)
+                mNextSize *= 2;
+
+            mCur = (char *)blk + align_up(sizeof(block));
+            mEnd = (char *)blk + block_size;
+
+            void *ptr = mCur;
+            mCur += size;
+            return ptr;
+        }
+
+        void monotonic_arena::release()
+        {
+            while (mHead)
+            {
+                block *prev = mHead->prev;
+                free(mHead);
+                mHead = prev;
+            }
+
+            mCur = mEnd = nullptr;
+            mCapacity = 0;
+        }
+
+        arena_scope::arena_scope(monotonic_arena *arena) : mPrev(tActiveArena) { tActiveArena = arena; }
+        arena_scope::~arena_scope() { tActiveArena = mPrev; }
+
+        struct alloc_header
+        {
+            monotonic_arena *arena;
+            size_t size;
+        };
+
+        static_assert(sizeof(alloc_header) == kArenaAlignment, "header must keep blocks aligned");
+
+        static void *alloc_from(monotonic_arena *arena, size_t size)
+        {
+            alloc_header *header;
+            if (arena)
+            {
+                header = (alloc_header *)arena->allocate(sizeof(alloc_header) + size);
+            }
+            else
+            {
+                header = (alloc_header *)malloc(sizeof(alloc_header) + size);
+                if (!header)
+                    throw std::bad_alloc{};
+            }
+
+            header->arena = arena;
+            header->size = size;
+            return header + 1;
+        }
+
+    } // namespace json_detail
+
+    void *json_allocator::Alloc(size_t size) { return json_detail::alloc_from(json_detail::tActiveArena, size); }
+
+    void *json_allocator::ReAlloc(void *ptr, size_t size)
+    {
+        using namespace json_detail;
+
+        if (!ptr)
+            return Alloc(size);
+
+        alloc_header *header = (alloc_header *)ptr - 1;
+        if (!header->arena)
+        {
+            header = (alloc_header *)realloc(header, sizeof(alloc_header) + size);
+            if (!header)
+                throw std::bad_alloc{};
+
+            header->size = size;
+            return header + 1;
+        }
+
+        if (size <= header->size)
+            return ptr;
+
+        void *result = alloc_from(header->arena, size);
+        memcpy(result, ptr, header->size);
+        return result;
+    }
+
+    void json_allocator::Free(void *ptr)
+    {
+        if (!ptr)
+            return;
+
+        auto header = (json_detail::alloc_header *)ptr - 1;
+        if (!header->arena)
+            free(header);
+    }
+
+} // namespace ulib
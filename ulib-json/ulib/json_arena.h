@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ulib
+{
+    namespace json_detail
+    {
+        // Bump allocator: memory is only given back all at once by release()
+        class monotonic_arena
+        {
+        public:
+            monotonic_arena(size_t first_block_size = 64 * 1024);
+            monotonic_arena(const monotonic_arena &) = delete;
+            monotonic_arena &operator=(const monotonic_arena &) = delete;
+            ~monotonic_arena();
+
+            // 16-byte aligned
+            void *allocate(size_t size);
+            void release();
+
+            size_t capacity() const { return mCapacity; }
+
+        private:
+            struct block
+            {
+                block *prev;
+                size_t size;
+            };
+
+            void *allocate_slow(size_t size);
+
+            block *mHead;
+            char *mCur;
+            char *mEnd;
+            size_t mNextSize;
+            size_t mCapacity;
+        };
+
+        // While alive, json containers created on this thread allocate from the arena
+        class arena_scope
+        {
+        public:
+            arena_scope(monotonic_arena *arena);
+            ~arena_scope();
+
+        private:
+            monotonic_arena *mPrev;
+        };
+
+    } // namespace json_detail
+
+    // Allocator of json containers. Every block carries a small header naming the arena
+    // it came from (or none), so blocks of a json::document can live next to heap blocks in
+    // one tree: freeing an arena block is a no-op and growing it stays in its arena.
+    class json_allocator
+    {
+    public:
+        struct Params
+        {
+        };
+
+        json_allocator(Params = {}) {}
+
+        void *Alloc(size_t size);
+        void *ReAlloc(void *ptr, size_t size);
+        void Free(void *ptr);
+    };
+
+} // namespace ulib
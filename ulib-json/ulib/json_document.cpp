@@ -0,0 +1,80 @@
+#include "json.h"
+#include "json_file.h"
+
+namespace ulib
+{
+    json::document::document() : mArena(std::make_unique<json_detail::monotonic_arena>()), mMutated(false)
+    {
+        new (&mRoot) json();
+    }
+
+    json::document::document(document &&other)
+        : mArena(std::move(other.mArena)), mFile(std::move(other.mFile)), mMutated(other.mMutated)
+    {
+        new (&mRoot) json(std::move(other.mRoot));
+        other.mArena = std::make_unique<json_detail::monotonic_arena>();
+        other.mMutated = false;
+    }
+
+    json::document &json::document::operator=(document &&other)
+    {
+        if (this == &other)
+            return *this;
+
+        reset();
+        mArena.swap(other.mArena);
+        mFile = std::move(other.mFile);
+        mRoot = std::move(other.mRoot);
+        mMutated = other.mMutated;
+        other.mMutated = false;
+        return *this;
+    }
+
+    json::document::~document()
+    {
+        if (mMutated)
+            mRoot.~json();
+    }
+
+    void json::document::parse(StringViewT str) { parse(str, parse_options{}); }
+
+    void json::document::parse(StringViewT str, const parse_options &options)
+    {
+        reset();
+
+        json_detail::arena_scope scope{mArena.get()};
+        parser prsr{options};
+
+        try
+        {
+            prsr.parse(str, mRoot);
+        }
+        catch (...)
+        {
+            // everything the parser allocated lives in the arena
+            new (&mRoot) json();
+            mArena->release();
+            throw;
+        }
+    }
+
+    void json::document::parse_file(const std::filesystem::path &path) { parse_file(path, parse_options{}); }
+
+    void json::document::parse_file(const std::filesystem::path &path, const parse_options &options)
+    {
+        auto file = std::make_unique<json_detail::mapped_file>(path);
+        parse(StringViewT{file->data(), file->size()}, options);
+        mFile = std::move(file);
+    }
+
+    void json::document::reset()
+    {
+        if (mMutated)
+            mRoot.~json();
+
+        new (&mRoot) json();
+        mArena->release();
+        mFile.reset();
+        mMutated = false;
+    }
+} // namespace ulib
@@ -0,0 +1,109 @@
+#include "json_file.h"
+#include "json.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ulib
+{
+    namespace json_detail
+    {
+        static json::exception file_error(const std::filesystem::path &path, const char *what)
+        {
+            return json::exception{ulib::string{"json parse_file(\""} + ulib::str(ulib::u8(path.generic_u8string())) +
+                                   "\") " + what};
+        }
+
+#ifdef _WIN32
+        mapped_file::mapped_file(const std::filesystem::path &path)
+            : mData(nullptr), mSize(0), mFile(INVALID_HANDLE_VALUE), mMapping(nullptr)
+        {
+            mFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (mFile == INVALID_HANDLE_VALUE)
+                throw file_error(path, "cannot open file");
+
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(mFile, &size))
+            {
+                CloseHandle(mFile);
+                throw file_error(path, "cannot get file size");
+            }
+
+            mSize = size_t(size.QuadPart);
+            if (!mSize)
+                return;
+
+            mMapping = CreateFileMappingW(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mMapping)
+                mData = (const char *)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+
+            if (!mData)
+            {
+                if (mMapping)
+                    CloseHandle(mMapping);
+                CloseHandle(mFile);
+                throw file_error(path, "cannot map file");
+            }
+        }
+
+        mapped_file::~mapped_file()
+        {
+            if (mData)
+                UnmapViewOfFile(mData);
+            if (mMapping)
+                CloseHandle(mMapping);
+            CloseHandle(mFile);
+        }
+#else
+        mapped_file::mapped_file(const std::filesystem::path &path) : mData(nullptr), mSize(0)
+        {
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw file_error(path, "cannot open file");
+
+            struct stat st;
+            if (fstat(fd, &st) != 0)
+            {
+                close(fd);
+                throw file_error(path, "cannot get file size");
+            }
+
+            mSize = size_t(st.st_size);
+            if (!mSize)
+            {
+                close(fd);
+                return;
+            }
+
+            void *data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+
+            if (data == MAP_FAILED)
+                throw file_error(path, "cannot map file");
+
+            // one forward pass: read ahead aggressively and drop pages behind
+            madvise(data, mSize, MADV_SEQUENTIAL);
+            madvise(data, mSize, MADV_WILLNEED);
+
+            mData = (const char *)data;
+        }
+
+        mapped_file::~mapped_file()
+        {
+            if (mData)
+                munmap((void *)mData, mSize);
+        }
+#endif
+
+    } // namespace json_detail
+} // namespace ulib
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+namespace ulib
+{
+    namespace json_detail
+    {
+        // Read only mapping of a whole file, hinted for one sequential pass. Nothing past size()
+        // is touched: stage 1 copies the last partial block into a padded buffer before loading it
+        class mapped_file
+        {
+        public:
+            mapped_file(const std::filesystem::path &path);
+            mapped_file(const mapped_file &) = delete;
+            mapped_file &operator=(const mapped_file &) = delete;
+            ~mapped_file();
+
+            const char *data() const { return mData; }
+            size_t size() const { return mSize; }
+
+        private:
+            const char *mData;
+            size_t mSize;
+#ifdef _WIN32
+            void *mFile;
+            void *mMapping;
+#endif
+        };
+
+    } // namespace json_detail
+} // namespace ulib
@@ -0,0 +1,137 @@
+#include "json.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace ulib
+{
+    namespace json_detail
+    {
+        static thread_local key_pool *tActiveKeyPool = nullptr;
+
+        // the text follows the header
+        struct key_pool::entry
+        {
+            uint64_t hash;
+            size_t size;
+
+            const char *text() const { return (const char *)(this + 1); }
+        };
+
+        // Open addressing, slots are only ever filled. Readers probe without locking, a writer
+        // fills a slot after the entry is complete and publishes a grown table as a whole
+        struct key_pool::table
+        {
+            table(size_t capacity) : mask(capacity - 1), slots(new std::atomic<const entry *>[capacity])
+            {
+                for (size_t i = 0; i != capacity; i++)
+                    slots[i].store(nullptr, std::memory_order_relaxed);
+            }
+
+            size_t mask;
+            std::unique_ptr<std::atomic<const entry *>[]> slots;
+        };
+
+        struct key_pool::state
+        {
+            std::atomic<table *> current{nullptr};
+            std::atomic<size_t> count{0};
+
+            // writers only
+            std::mutex mutex;
+            monotonic_arena text{4 * 1024};
+            // replaced tables, readers may still be probing them
+            std::vector<std::unique_ptr<table>> tables;
+        };
+
+        key_pool::key_pool() : mState(std::make_unique<state>())
+        {
+            mState->tables.push_back(std::make_unique<table>(64));
+            mState->current.store(mState->tables.back().get(), std::memory_order_release);
+        }
+
+        key_pool::~key_pool() = default;
+
+        const key_pool::entry *key_pool::lookup(ulib::string_view name, uint64_t hash) const
+        {
+            const table *t = mState->current.load(std::memory_order_acquire);
+            for (size_t i = hash & t->mask;; i = (i + 1) & t->mask)
+            {
+                const entry *e = t->slots[i].load(std::memory_order_acquire);
+                if (!e)
+                    return nullptr;
+
+                if (e->hash == hash && e->size == name.size() && memcmp(e->text(), name.data(), e->size) == 0)
+                    return e;
+            }
+        }
+
+        ulib::string_view key_pool::intern(ulib::string_view name)
+        {
+            uint64_t hash = hash_key(name.data(), name.size());
+            if (const entry *e = lookup(name, hash))
+                return ulib::string_view{e->text(), e->size};
+
+            std::lock_guard<std::mutex> guard(mState->mutex);
+
+            // added by another thread meanwhile
+            if (const entry *e = lookup(name, hash))
+                return ulib::string_view{e->text(), e->size};
+
+            entry *e = (entry *)mState->text.allocate(sizeof(entry) + name.size());
+            e->hash = hash;
+            e->size = name.size();
+            memcpy((char *)e->text(), name.data(), name.size());
+
+            table *t = mState->current.load(std::memory_order_relaxed);
+            size_t i = hash & t->mask;
+            while (t->slots[i].load(std::memory_order_relaxed))
+                i = (i + 1) & t->mask;
+
+            t->slots[i].store(e, std::memory_order_release);
+            size_t count = mState->count.load(std::memory_order_relaxed) + 1;
+            mState->count.store(count, std::memory_order_relaxed);
+
+            // at half load the next table is filled privately, then published
+            if (count * 2 > t->mask + 1)
+            {
+                auto grown = std::make_unique<table>((t->mask + 1) * 2);
+                for (size_t j = 0; j <= t->mask; j++)
+                {
+                    const entry *moved = t->slots[j].load(std::memory_order_relaxed);
+                    if (!moved)
+                        continue;
+
+                    size_t k = moved->hash & grown->mask;
+                    while (grown->slots[k].load(std::memory_order_relaxed))
+                        k = (k + 1) & grown->mask;
+
+                    grown->slots[k].store(moved, std::memory_order_relaxed);
+                }
+
+                mState->current.store(grown.get(), std::memory_order_release);
+                mState->tables.push_back(std::move(grown));
+            }
+
+            return ulib::string_view{e->text(), e->size};
+        }
+
+        std::optional<ulib::string_view> key_pool::find(ulib::string_view name) const
+        {
+            const entry *e = lookup(name, hash_key(name.data(), name.size()));
+            if (!e)
+                return std::nullopt;
+
+            return ulib::string_view{e->text(), e->size};
+        }
+
+        size_t key_pool::size() const { return mState->count.load(std::memory_order_relaxed); }
+
+        key_pool::scope::scope(key_pool *pool) : mPrev(tActiveKeyPool) { tActiveKeyPool = pool; }
+        key_pool::scope::~scope() { tActiveKeyPool = mPrev; }
+
+        key_pool *key_pool::active() { return tActiveKeyPool; }
+
+    } // namespace json_detail
+} // namespace ulib
@@ -0,0 +1,128 @@
+#include "json.h"
+
+namespace ulib
+{
+    using StringViewT = typename json::StringViewT;
+    using value_t = typename json::value_t;
+
+    static ParseError parse_error(const json::parser &prsr)
+    {
+        return ParseError{ulib::string{json::errc_to_string(prsr.status().error)}};
+    }
+
+    json::lazy_document::lazy_document(StringViewT str) : mParser(std::make_unique<parser>())
+    {
+        mParser->set_str(str);
+        mParser->advance();
+        if (mParser->mIt == mParser->mEnd)
+            throw ParseError{"Unexpected end of file"};
+
+        mRoot = mParser->mIt;
+    }
+
+    json::lazy_value json::lazy_value::operator[](StringViewT name) const
+    {
+        if (*mPos != '{')
+            throw exception{ulib::string{"in json lazy_value[\""} + name + "\"]" + " json must be an object"};
+
+        const char *pos = mParser->find_field(mPos, name);
+        if (!pos && !mParser->status())
+            throw parse_error(*mParser);
+        if (!pos)
+            throw exception{ulib::string{"in json lazy_value[\""} + name + "\"]" + " key not found"};
+
+        return lazy_value{mParser, pos};
+    }
+
+    json::lazy_value json::lazy_value::operator[](size_t idx) const
+    {
+        if (*mPos != '[')
+            throw exception{ulib::string{"in json lazy_value["} + std::to_string(idx) + "]" +
+                            " json must be an array"};
+
+        const char *pos = mParser->find_element(mPos, idx);
+        if (!pos && !mParser->status())
+            throw parse_error(*mParser);
+        if (!pos)
+            throw exception{ulib::string{"in json lazy_value["} + std::to_string(idx) + "]" +
+                            " index out of range"};
+
+        return lazy_value{mParser, pos};
+    }
+
+    std::optional<json::lazy_value> json::lazy_value::find(StringViewT name) const
+    {
+        if (*mPos != '{')
+            return std::nullopt;
+
+        const char *pos = mParser->find_field(mPos, name);
+        if (!pos && !mParser->status())
+            throw parse_error(*mParser);
+        if (!pos)
+            return std::nullopt;
+
+        return lazy_value{mParser, pos};
+    }
+
+    value_t json::lazy_value::type() const
+    {
+        switch (*mPos)
+        {
+        case '{':
+            return value_t::object;
+        case '[':
+            return value_t::array;
+        case '\"':
+            return value_t::string;
+        case 't':
+        case 'f':
+            return value_t::boolean;
+        case 'n':
+            return value_t::null;
+        default:
+            break;
+        }
+
+        json_detail::number num;
+        if (!json_detail::parse_number(mPos, mParser->mEnd, num))
+            throw ParseError{"Invalid number"};
+
+        switch (num.kind)
+        {
+        case json_detail::number_kind::integer:
+            return value_t::integer;
+        case json_detail::number_kind::unsigned_integer:
+            return value_t::unsigned_integer;
+        default:
+            return value_t::floating;
+        }
+    }
+
+    json json::lazy_value::value() const
+    {
+        json out;
+        mParser->seek(mPos);
+        if (!mParser->parse_value(&out))
+            throw parse_error(*mParser);
+
+        return out;
+    }
+
+    StringViewT json::lazy_value::string_view() const
+    {
+        if (*mPos != '\"')
+            throw exception{ulib::string{"json invalid get() type. expected: string. current: "} +
+                            type_to_string(type())};
+
+        mParser->seek(mPos);
+        mParser->mIt++;
+
+        StringViewT str;
+        bool escaped;
+        if (!mParser->parse_quote_end_string(str, escaped))
+            throw parse_error(*mParser);
+
+        return str;
+    }
+
+} // namespace ulib
@@ -0,0 +1,285 @@
+#include "json.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ulib
+{
+    using StringViewT = typename json::StringViewT;
+    using errc = typename json::errc;
+
+    // chunks in flight per worker: bounds memory while keeping every queue fed
+    constexpr size_t kChunksPerWorker = 4;
+
+    struct json::ndjson_reader::chunk
+    {
+        const char *begin;
+        const char *end;
+
+        // results, the list keeps its capacity when the slot is reused
+        ulib::List<json> values;
+        size_t lines;
+        std::exception_ptr error;
+        bool ready;
+    };
+
+    struct json::ndjson_reader::pool
+    {
+        struct worker
+        {
+            worker(const parse_options &options) : prsr(options) {}
+
+            std::mutex lock;
+            std::deque<size_t> tasks;
+            parser prsr;
+        };
+
+        pool(const ndjson_options &options) : chunkSize(options.chunk_size ? options.chunk_size : 1)
+        {
+            size_t count = options.threads ? options.threads : std::thread::hardware_concurrency();
+            if (!count)
+                count = 1;
+
+            for (size_t i = 0; i != count; i++)
+                workers.push_back(std::make_unique<worker>(options.parse));
+
+            slots = std::vector<chunk>(count * kChunksPerWorker);
+            for (size_t i = 0; i != count; i++)
+                threads.emplace_back([this, i] { run(i); });
+        }
+
+        ~pool()
+        {
+            {
+                std::lock_guard<std::mutex> guard(mutex);
+                stop = true;
+            }
+
+            workCv.notify_all();
+            for (auto &thread : threads)
+                thread.join();
+        }
+
+        // own queue from the front, others from the back
+        bool pop(size_t self, size_t &task)
+        {
+            for (size_t i = 0; i != workers.size(); i++)
+            {
+                worker &w = *workers[(self + i) % workers.size()];
+                std::lock_guard<std::mutex> guard(w.lock);
+                if (w.tasks.empty())
+                    continue;
+
+                if (i == 0)
+                {
+                    task = w.tasks.front();
+                    w.tasks.pop_front();
+                }
+                else
+                {
+                    task = w.tasks.back();
+                    w.tasks.pop_back();
+                }
+
+                pending--;
+                return true;
+            }
+
+            return false;
+        }
+
+        void run(size_t self)
+        {
+            while (true)
+            {
+                size_t task;
+                if (!pop(self, task))
+                {
+                    std::unique_lock<std::mutex> guard(mutex);
+                    workCv.wait(guard, [this] { return stop || pending != 0; });
+                    if (stop)
+                        return;
+
+                    continue;
+                }
+
+                chunk &slot = slots[task % slots.size()];
+                if (!cancel)
+                {
+                    try
+                    {
+                        parse_chunk(workers[self]->prsr, slot);
+                    }
+                    catch (...)
+                    {
+                        slot.error = std::current_exception();
+                    }
+                }
+
+                {
+                    std::lock_guard<std::mutex> guard(mutex);
+                    slot.ready = true;
+                }
+
+                doneCv.notify_all();
+            }
+        }
+
+        // queues the chunk starting at pos, returns its end
+        const char *submit(size_t index, const char *pos, const char *end)
+        {
+            const char *stop = size_t(end - pos) > chunkSize ? pos + chunkSize : end;
+            if (stop != end)
+            {
+                const char *nl = (const char *)memchr(stop, '\n', size_t(end - stop));
+                stop = nl ? nl + 1 : end;
+            }
+
+            chunk &slot = slots[index % slots.size()];
+            slot.begin = pos;
+            slot.end = stop;
+            slot.values.clear();
+            slot.lines = 0;
+            slot.error = nullptr;
+            slot.ready = false;
+
+            // counted before it is queued: a worker stealing it right away must not take pending below zero
+            {
+                std::lock_guard<std::mutex> guard(mutex);
+                pending++;
+            }
+
+            worker &w = *workers[index % workers.size()];
+            {
+                std::lock_guard<std::mutex> guard(w.lock);
+                w.tasks.push_back(index);
+            }
+
+            workCv.notify_one();
+            return stop;
+        }
+
+        void wait(chunk &slot)
+        {
+            std::unique_lock<std::mutex> guard(mutex);
+            doneCv.wait(guard, [&slot] { return slot.ready; });
+        }
+
+        size_t chunkSize;
+        std::vector<std::unique_ptr<worker>> workers;
+        std::vector<chunk> slots;
+        std::vector<std::thread> threads;
+
+        std::mutex mutex;
+        std::condition_variable workCv;
+        std::condition_variable doneCv;
+        std::atomic<size_t> pending{0};
+        std::atomic<bool> cancel{false};
+        bool stop = false;
+    };
+
+    json::ndjson_reader::ndjson_reader(const ndjson_options &options) : mPool(std::make_unique<pool>(options)) {}
+
+    json::ndjson_reader::~ndjson_reader() = default;
+
+    size_t json::ndjson_reader::read(StringViewT buffer, const std::function<bool(json &)> &callback)
+    {
+        pool &p = *mPool;
+        const char *pos = buffer.begin().raw();
+        const char *end = buffer.end().raw();
+
+        size_t submitted = 0;
+        for (; submitted != p.slots.size() && pos != end; submitted++)
+            pos = p.submit(submitted, pos, end);
+
+        size_t delivered = 0;
+        size_t line = 0;
+        std::exception_ptr error;
+        bool stopped = false;
+
+        for (size_t index = 0; index != submitted; index++)
+        {
+            chunk &slot = p.slots[index % p.slots.size()];
+            p.wait(slot);
+
+            if (!stopped)
+            {
+                try
+                {
+                    for (auto &value : slot.values)
+                    {
+                        delivered++;
+                        if (!callback(value))
+                        {
+                            stopped = true;
+                            break;
+                        }
+                    }
+
+                    if (!stopped && slot.error)
+                        std::rethrow_exception(slot.error);
+                }
+                catch (const ParseError &e)
+                {
+                    error = std::make_exception_ptr(
+                        ParseError{ulib::string{"line "} + std::to_string(line + slot.lines + 1) + ": " + e.what()});
+                    stopped = true;
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                    stopped = true;
+                }
+
+                // later chunks are still drained, they reference the buffer
+                if (stopped)
+                    p.cancel = true;
+            }
+
+            line += slot.lines;
+            if (!stopped && pos != end)
+                pos = p.submit(submitted++, pos, end);
+        }
+
+        p.cancel = false;
+        if (error)
+            std::rethrow_exception(error);
+
+        return delivered;
+    }
+
+    // slot.lines counts the lines before the first malformed one
+    void json::ndjson_reader::parse_chunk(parser &prsr, chunk &out)
+    {
+        const char *p = out.begin;
+        while (p != out.end)
+        {
+            const char *nl = (const char *)memchr(p, '\n', size_t(out.end - p));
+            const char *line_end = nl ? nl : out.end;
+
+            prsr.set_str(ulib::string_view{p, size_t(line_end - p)});
+            prsr.advance();
+            if (prsr.mIt != prsr.mEnd)
+            {
+                json &value = out.values.emplace_back();
+                if (prsr.parse_value(&value) && prsr.mIt != prsr.mEnd)
+                    prsr.fail(errc::unexpected_character, prsr.mIt);
+
+                if (!prsr.status())
+                {
+                    out.values.pop_back();
+                    throw ParseError{ulib::string{errc_to_string(prsr.status().error)}};
+                }
+            }
+
+            out.lines++;
+            p = nl ? nl + 1 : out.end;
+        }
+    }
+
+} // namespace ulib
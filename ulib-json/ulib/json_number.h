@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace ulib
+{
+    namespace json_detail
+    {
+        enum class number_kind
+        {
+            integer,
+            unsigned_integer,
+            floating
+        };
+
+        struct number
+        {
+            number_kind kind;
+            union {
+                int64_t i;
+                uint64_t u;
+                double d;
+            };
+
+            template <class T>
+            T as() const
+            {
+                if (kind == number_kind::integer)
+                    return T(i);
+                if (kind == number_kind::unsigned_integer)
+                    return T(u);
+                return T(d);
+            }
+        };
+
+        // Parses the json number at p. Integers that fit int64/uint64 are never converted through
+        // floating point, other numbers are rounded correctly to double (Eisel-Lemire).
+        // Returns the end of the number or nullptr if it is malformed.
+        const char *parse_number(const char *p, const char *end, number &out);
+
+        // Checks the json number at p without converting it. int_digits: the digits before the
+        // fraction, integral: there is neither a fraction nor an exponent.
+        // Returns the end of the number or nullptr if it is malformed.
+        const char *scan_number(const char *p, const char *end, size_t &int_digits, bool &integral);
+
+        inline uint64_t read8_le(const char *p)
+        {
+            uint64_t v;
+            memcpy(&v, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            v = __builtin_bswap64(v);
+#endif
+            return v;
+        }
+
+        inline bool is_eight_digits(uint64_t v)
+        {
+            return !(((v + 0x4646464646464646ULL) | (v - 0x3030303030303030ULL)) & 0x8080808080808080ULL);
+        }
+
+        // swar: converts 8 ascii digits (first digit in the lowest byte) in three multiplications
+        inline uint32_t parse_eight_digits(uint64_t v)
+        {
+            const uint64_t mask = 0x000000FF000000FFULL;
+            const uint64_t mul1 = 0x000F424000000064ULL; // 100 + (1000000 << 32)
+            const uint64_t mul2 = 0x0000271000000001ULL; // 1 + (10000 << 32)
+
+            v -= 0x3030303030303030ULL;
+            v = (v * 10) + (v >> 8);
+            v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+            return uint32_t(v);
+        }
+
+    } // namespace json_detail
+} // namespace ulib
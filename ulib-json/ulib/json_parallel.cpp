@@ -0,0 +1,292 @@
+#include "json.h"
+#include "json_simd.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ulib
+{
+    using errc = typename json::errc;
+    using value_t = typename json::value_t;
+    using ArrayT = typename json::ArrayT;
+
+    // less input than this per worker isn't worth the threads
+    constexpr size_t kMinParallelChunk = 1024 * 1024;
+
+    // ranges per worker, so one slow range doesn't leave the others idle
+    constexpr size_t kRangesPerWorker = 4;
+
+    // Runs task(worker, index) for every index below count on workers threads, the calling one included.
+    // The first exception is rethrown once all of them finished
+    template <class TaskT>
+    static void run_parallel(size_t workers, size_t count, TaskT &&task)
+    {
+        std::atomic<size_t> next{0};
+        std::mutex lock;
+        std::exception_ptr error;
+
+        auto run = [&](size_t worker) {
+            for (size_t i; (i = next++) < count;)
+            {
+                try
+                {
+                    task(worker, i);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    if (!error)
+                        error = std::current_exception();
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < workers; i++)
+            threads.emplace_back(run, i);
+
+        run(0);
+        for (auto &thread : threads)
+            thread.join();
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    // Calls fn(block, in_string, at) for the 64 byte blocks of [p, end) until it returns false. in_string
+    // is the stage 1 mask, carried from the state at p, and at the position of the block's first byte
+    template <class BlockFn>
+    static void scan_blocks(const char *p, const char *end, bool in_string, BlockFn &&fn)
+    {
+        json_detail::scanner_state state;
+        state.prev_in_string = in_string ? ~uint64_t(0) : 0;
+
+        for (; p < end; p += 64)
+        {
+            const char *base = p;
+            char block[64];
+            if (end - p < 64)
+            {
+                // the tail is padded with spaces so the block load never reads past the input
+                memset(block, ' ', sizeof(block));
+                memcpy(block, p, size_t(end - p));
+                base = block;
+            }
+
+            json_detail::block64 in(base);
+            uint64_t escaped = json_detail::escaped_chars(in.eq('\\'), state.prev_escaped);
+            uint64_t quote = in.eq('\"') & ~escaped;
+            uint64_t mask = json_detail::prefix_xor(quote) ^ state.prev_in_string;
+            state.prev_in_string = uint64_t(int64_t(mask) >> 63);
+
+            if (!fn(in, mask, p))
+                return;
+        }
+    }
+
+    // A slice of the input between two offsets. Its string state and nesting at the start depend on
+    // everything before it, so the first pass summarizes it for both string states it may start in
+    struct parallel_range
+    {
+        const char *begin;
+        const char *end;
+
+        // the range ends in the other string state than it starts in
+        bool flips_string = false;
+        int64_t depth_outside = 0;
+        int64_t depth_inside = 0;
+
+        // resolved from the ranges before
+        bool starts_in_string = false;
+        int64_t start_depth = 0;
+
+        // the first ',' between elements of the top level array, nullptr if there is none
+        const char *split = nullptr;
+
+        void summarize()
+        {
+            bool in_string = false;
+            scan_blocks(begin, end, false, [&](const json_detail::block64 &in, uint64_t mask, const char *) {
+                uint64_t open = in.eq_lower('{');
+                uint64_t close = in.eq_lower('}');
+                depth_outside += json_detail::popcount(open & ~mask) - json_detail::popcount(close & ~mask);
+                depth_inside += json_detail::popcount(open & mask) - json_detail::popcount(close & mask);
+                in_string = int64_t(mask) < 0;
+                return true;
+            });
+
+            flips_string = in_string;
+        }
+
+        void find_split()
+        {
+            int64_t depth = start_depth;
+            scan_blocks(begin, end, starts_in_string, [&](const json_detail::block64 &in, uint64_t mask, const char *at) {
+                uint64_t open = in.eq_lower('{') & ~mask;
+                uint64_t close = in.eq_lower('}') & ~mask;
+                uint64_t comma = in.eq(',') & ~mask;
+
+                if (!comma)
+                {
+                    depth += json_detail::popcount(open) - json_detail::popcount(close);
+                    return depth > 0;
+                }
+
+                for (uint64_t bits = open | close | comma; bits; bits &= bits - 1)
+                {
+                    uint64_t bit = bits & (0 - bits);
+                    if (comma & bit)
+                    {
+                        // padding past end is never a comma
+                        if (depth == 1)
+                            return split = at + json_detail::trailing_zeroes(bit), false;
+                    }
+                    else if (!(depth += (open & bit) ? 1 : -1))
+                    {
+                        return false;
+                    }
+                }
+
+                return true;
+            });
+        }
+    };
+
+    json json::parser::parse_parallel(ulib::string_view str, size_t threads)
+    {
+        if (!threads)
+            threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+        const char *begin = str.data();
+        const char *end = begin + str.size();
+
+        const char *open = begin;
+        while (open != end && (*open == ' ' || *open == '\n' || *open == '\r' || *open == '\t'))
+            open++;
+
+        size_t workers = std::min(threads, str.size() / kMinParallelChunk);
+        if (workers < 2 || open == end || *open != '[' || mOptions.max_depth == 0)
+            return parse(str);
+
+        // ranges start inside the array, never right after a backslash: the escape state there is known
+        size_t count = workers * kRangesPerWorker;
+        std::vector<parallel_range> ranges(count);
+        const char *contents = open + 1;
+        for (size_t i = 0; i != count; i++)
+        {
+            const char *at = i ? contents + size_t(end - contents) / count * i : contents;
+            while (at != end && at != contents && at[-1] == '\\')
+                at++;
+            if (i && at < ranges[i - 1].begin)
+                at = ranges[i - 1].begin;
+
+            ranges[i].begin = at;
+            if (i)
+                ranges[i - 1].end = at;
+        }
+        ranges.back().end = end;
+
+        run_parallel(workers, count, [&](size_t, size_t i) { ranges[i].summarize(); });
+
+        bool in_string = false;
+        int64_t depth = 1;
+        for (auto &range : ranges)
+        {
+            range.starts_in_string = in_string;
+            range.start_depth = depth;
+            depth += in_string ? range.depth_inside : range.depth_outside;
+            in_string = in_string != range.flips_string;
+        }
+
+        run_parallel(workers, count, [&](size_t, size_t i) { ranges[i].find_split(); });
+
+        // a chunk runs from after a split to the next one, the last one holds the closing bracket
+        std::vector<const char *> starts{contents};
+        for (auto &range : ranges)
+        {
+            if (range.split)
+                starts.push_back(range.split + 1);
+        }
+
+        std::vector<ArrayT> parts(starts.size());
+        std::vector<parse_status> results(starts.size());
+
+        parse_options options = mOptions;
+        options.max_depth--;
+        std::vector<parser> parsers(workers, parser{options});
+
+        run_parallel(workers, starts.size(), [&](size_t worker, size_t i) {
+            bool last = i + 1 == starts.size();
+            const char *stop = last ? end : starts[i + 1] - 1;
+
+            parser &prsr = parsers[worker];
+            prsr.parse_elements(ulib::string_view{starts[i], size_t(stop - starts[i])}, i == 0, last, parts[i]);
+            results[i] = prsr.status();
+            if (!results[i])
+                results[i].offset += size_t(starts[i] - begin);
+        });
+
+        set_str(str);
+        for (auto &result : results)
+        {
+            if (!result)
+            {
+                fail(result.error, begin + result.offset);
+                throw ParseError{error_message()};
+            }
+        }
+
+        // elements are moved, their subtrees stay where the workers built them
+        std::vector<size_t> offsets(parts.size() + 1);
+        for (size_t i = 0; i != parts.size(); i++)
+            offsets[i + 1] = offsets[i] + parts[i].size();
+
+        json out{value_t::array};
+        out.mArray->resize(offsets.back());
+        run_parallel(workers, parts.size(), [&](size_t, size_t i) {
+            std::move(parts[i].begin(), parts[i].end(), out.mArray->begin() + offsets[i]);
+            parts[i] = ArrayT{};
+        });
+
+        return out;
+    }
+
+    bool json::parser::parse_elements(ulib::string_view chunk, bool first, bool last, ArrayT &out)
+    {
+        set_str(chunk);
+        advance();
+
+        // an empty array is never split
+        if (first && last && token() == ']')
+        {
+            advance();
+            return true;
+        }
+
+        while (true)
+        {
+            if (!parse_value(&out.emplace_back()))
+                return false;
+
+            if (token() == ',')
+            {
+                advance();
+                continue;
+            }
+
+            if (!last)
+                return mIt == mEnd || unexpected();
+
+            if (token() != ']')
+                return unexpected();
+
+            advance();
+            return true;
+        }
+    }
+
+} // namespace ulib
@@ -1,12 +1,51 @@
 #include "json.h"
+#include "json_simd.h"
+#include "json_number.h"
+#include "json_unicode.h"
+#include "json_file.h"
+
+#include <algorithm>
 
 namespace ulib
 {
-    ULIB_RUNTIME_ERROR(ParseError);
-
     using StringViewT = typename json::StringViewT;
     using StringT = typename json::StringT;
     using value_t = typename json::value_t;
+    using errc = typename json::errc;
+
+    // bytes classified per stage 1 refill, keeps the index small enough to stay in cache
+    constexpr size_t kWindowSize = 64 * 256;
+
+    // initial size of the container stack, enough for typical documents
+    constexpr size_t kStackReserve = 32;
+
+    // buffers kept by trim_buffers(), the stage 1 index has a fixed size and is always kept
+    constexpr size_t kRetainedBufferBytes = 64 * 1024;
+
+    // the parser lives as long as its thread, so one huge document must not pin its buffers there
+    static json parse_on_thread(StringViewT str, const json::parse_options &options)
+    {
+        thread_local json::parser prsr;
+        prsr.set_options(options);
+
+        json out;
+        try
+        {
+            prsr.parse(str, out);
+        }
+        catch (...)
+        {
+            prsr.trim_buffers();
+            throw;
+        }
+
+        prsr.trim_buffers();
+        return out;
+    }
+
+    json json::parse(StringViewT str) { return parse_on_thread(str, parse_options{}); }
+
+    json json::parse(StringViewT str, const parse_options &options) { return parse_on_thread(str, options); }
 
     json json::parser::parse(ulib::string_view str)
     {
@@ -17,10 +56,78 @@ namespace ulib
 
     void json::parser::parse(ulib::string_view str, json &out)
     {
+        if (!try_parse(str, out))
+            throw ParseError{error_message()};
+    }
+
+    void json::parser::trim_buffers()
+    {
+        if (mEscapeBuffer.size() > kRetainedBufferBytes)
+            mEscapeBuffer = ulib::List<char>{};
+        if (mKeyTable.size() * sizeof(uint32_t) > kRetainedBufferBytes)
+            mKeyTable = ulib::List<uint32_t>{};
+        if (mStack.size() * sizeof(frame) > kRetainedBufferBytes)
+            mStack = ulib::List<frame>{};
+    }
+
+    json::parse_status json::parser::try_parse(ulib::string_view str, json &out)
+    {
+        if (!mOptions.reuse_storage)
+            out.assign(value_t::null);
+
         set_str(str);
+        advance();
+        parse_value(&out);
+        return status();
+    }
+
+    json json::parser::parse_file(const std::filesystem::path &path)
+    {
+        json_detail::mapped_file file{path};
+
+        // the mapping ends with this call: strings can't point into it,
+        // and the error message is formatted while it still exists
+        bool in_situ = mOptions.in_situ;
+        mOptions.in_situ = false;
+
+        json obj;
+        bool ok;
+        try
+        {
+            ok = bool(try_parse(ulib::string_view{file.data(), file.size()}, obj));
+        }
+        catch (...)
+        {
+            mOptions.in_situ = in_situ;
+            set_str(ulib::string_view{});
+            throw;
+        }
+
+        mOptions.in_situ = in_situ;
+        if (!ok)
+        {
+            ulib::string message = error_message();
+            set_str(ulib::string_view{});
+            throw ParseError{message};
+        }
+
+        set_str(ulib::string_view{});
+        return obj;
+    }
+
+    json::parse_status json::parser::status() const
+    {
+        if (mError == errc::ok)
+            return parse_status{};
+
+        return parse_status{mError, size_t(mErrorAt - mBegin)};
+    }
 
-        value_t vt = pending_value();
-        parse_value(vt, &out);
+    ulib::string json::parser::error_message()
+    {
+        auto pos = error_pos();
+        return ulib::string{errc_to_string(mError)} + " at " + std::to_string(pos.first) + ":" +
+               std::to_string(pos.second);
     }
 
     std::pair<int, int> json::parser::error_pos()
@@ -29,7 +136,7 @@ namespace ulib
         int symbol = 1;
 
         auto it = mBegin;
-        auto end = mIt;
+        auto end = mError != errc::ok ? mErrorAt : mIt;
 
         while (it != end)
         {
@@ -50,385 +157,808 @@ namespace ulib
         return std::pair<int, int>(line, symbol);
     }
 
-    void json::parser::step()
+    void json::parser::advance()
     {
-        mIt++;
-        if (mIt == mEnd)
-            throw ParseError{"Unexpected end of file"};
+        while (mNextStructural == mStructuralsCount)
+        {
+            if (!index_window())
+            {
+                mIt = mEnd;
+                return;
+            }
+        }
+
+        mIt = mWindow + mStructurals[mNextStructural++];
     }
 
-    bool json::parser::step_check_eof()
+    bool json::parser::index_window()
     {
-        mIt++;
-        return mIt != mEnd;
+        if (mIndexed == mEnd)
+            return false;
+
+        if (mStructurals.size() < kWindowSize)
+            mStructurals.resize(kWindowSize);
+
+        size_t len = size_t(mEnd - mIndexed);
+        if (len > kWindowSize)
+            len = kWindowSize;
+
+        uint32_t *out = mStructurals.data();
+        size_t count = 0;
+        size_t offset = 0;
+
+        for (; offset + 64 <= len; offset += 64)
+        {
+            uint64_t bits = json_detail::scanner::next(mIndexed + offset, mScanner);
+            count += json_detail::flatten_bits(bits, uint32_t(offset), out + count);
+        }
+
+        if (offset != len)
+        {
+            // pad the tail with spaces so the block load never reads past the input
+            char block[64];
+            memset(block, ' ', sizeof(block));
+            memcpy(block, mIndexed + offset, len - offset);
+
+            uint64_t bits = json_detail::scanner::next(block, mScanner);
+            count += json_detail::flatten_bits(bits, uint32_t(offset), out + count);
+        }
+
+        mWindow = mIndexed;
+        mIndexed += len;
+        mStructuralsCount = count;
+        mNextStructural = 0;
+
+        return true;
     }
 
-    void json::parser::skip_spaces()
+    void json::parser::seek(const char *pos)
     {
-        while (mIt != mEnd)
+        mError = errc::ok;
+
+        if (pos >= mWindow && pos < mIndexed)
         {
-            switch (*mIt)
+            const uint32_t *begin = mStructurals.data();
+            const uint32_t *end = begin + mStructuralsCount;
+            const uint32_t *it = std::lower_bound(begin, end, uint32_t(pos - mWindow));
+            if (it != end && mWindow + *it == pos)
             {
-            case ' ':
-            case '\n':
-            case '\r':
-            case '\t':
-                mIt++;
-                continue;
-            default:
+                mNextStructural = size_t(it - begin) + 1;
+                mIt = pos;
                 return;
             }
         }
 
-        throw ParseError{"Unexpected end of file"};
+        // a value starts outside of any string, so indexing can restart there
+        mIndexed = pos;
+        mScanner = {};
+        mStructuralsCount = 0;
+        mNextStructural = 0;
+        advance();
     }
 
-    value_t json::parser::pending_value()
+    bool json::parser::skip_value()
     {
-        skip_spaces();
-
-        if (*mIt == '{')
+        char open = token();
+        if (open != '{' && open != '[')
         {
-            step();
-            skip_spaces();
+            if (mIt == mEnd || open == '}' || open == ']' || open == ',' || open == ':')
+                return unexpected();
 
-            return value_t::object;
+            // a scalar is a single structural, a string only its opening quote
+            advance();
+            return true;
         }
 
-        if (*mIt == '[')
+        // brackets are counted on the index while it lasts, small values end there.
+        // Past the window the input is scanned directly instead of being indexed
+        size_t depth = 0;
+        while (true)
         {
-            step();
-            skip_spaces();
+            switch (*mIt)
+            {
+            case '{':
+            case '[':
+                depth++;
+                break;
+            case '}':
+            case ']':
+                if (!--depth)
+                {
+                    advance();
+                    return true;
+                }
+                break;
+            default:
+                break;
+            }
+
+            if (mNextStructural == mStructuralsCount)
+                break;
 
-            return value_t::array;
+            mIt = mWindow + mStructurals[mNextStructural++];
         }
 
-        if (*mIt == '\"')
+        const char *close = json_detail::find_container_end(mIndexed, mEnd, mScanner, depth);
+        if (!close)
         {
-            step();
-            return value_t::string;
+            mIt = mEnd;
+            return unexpected();
         }
 
-        if ((*mIt >= '0' && *mIt <= '9') || *mIt == '-')
+        // indexing restarts at the bracket, outside of any string
+        seek(close);
+        advance();
+        return true;
+    }
+
+    size_t json::parser::skip(ulib::string_view str, size_t offset)
+    {
+        set_str(str);
+        seek(mBegin + offset);
+        if (!skip_value())
+            throw ParseError{ulib::string{errc_to_string(mError)}};
+
+        return size_t(mIt - mBegin);
+    }
+
+    const char *json::parser::find_field(const char *object, StringViewT name)
+    {
+        seek(object);
+        advance(); // '{'
+        if (token() == '}')
+            return nullptr;
+
+        while (true)
         {
-            return value_t::integer;
+            if (token() != '\"')
+                return unexpected(), nullptr;
+
+            mIt++;
+            StringViewT key;
+            bool escaped;
+            if (!parse_quote_end_string(key, escaped))
+                return nullptr;
+
+            advance();
+            if (token() != ':')
+                return unexpected(), nullptr;
+
+            advance();
+            if (key == name)
+                return mIt;
+
+            if (!skip_value())
+                return nullptr;
+
+            if (token() == ',')
+                advance();
+            else if (token() == '}')
+                return nullptr;
+            else
+                return unexpected(), nullptr;
         }
+    }
+
+    const char *json::parser::find_element(const char *array, size_t idx)
+    {
+        seek(array);
+        advance(); // '['
+        if (token() == ']')
+            return nullptr;
 
-        if (*mIt == 'f' || *mIt == 't')
+        while (true)
         {
-            step();
-            return value_t::boolean;
+            if (!idx--)
+                return mIt;
+
+            if (!skip_value())
+                return nullptr;
+
+            if (token() == ',')
+                advance();
+            else if (token() == ']')
+                return nullptr;
+            else
+                return unexpected(), nullptr;
         }
+    }
 
-        if (*mIt == 'n')
+    bool json::parser::fail(errc code, const char *at)
+    {
+        // the first error is the one reported
+        if (mError == errc::ok)
         {
-            step();
-            return value_t::null;
+            mError = code;
+            mErrorAt = at;
         }
 
-        throw ParseError{"json invalid value type"};
+        return false;
     }
 
-    void json::parser::parse_value(value_t vt, json *out)
+    bool json::parser::unexpected()
     {
-        switch (vt)
+        return fail(mIt == mEnd ? errc::unexpected_end : errc::unexpected_character, mIt);
+    }
+
+    bool json::parser::wrong_type()
+    {
+        return fail(mIt == mEnd ? errc::unexpected_end : errc::wrong_type, mIt);
+    }
+
+    // scalars must be followed by whitespace, an operator or the end of input
+    bool json::parser::finish_atom()
+    {
+        if (mIt != mEnd)
         {
-        case value_t::object:
-            parse_object(out);
-            break;
-        case value_t::array:
-            parse_array(out);
-            break;
-        case value_t::integer:
-            parse_integer(out);
-            break;
-        case value_t::string:
-            parse_string(out);
-            break;
-        case value_t::boolean:
-            parse_boolean(out);
-            break;
-        case value_t::null:
-            parse_null(out);
-            break;
-        default:
-            throw ParseError{"Unexpected type of value"};
+            switch (*mIt)
+            {
+            case ' ':
+            case '\n':
+            case '\r':
+            case '\t':
+            case ',':
+            case ']':
+            case '}':
+            case ':':
+                break;
+            default:
+                return fail(errc::unexpected_character, mIt);
+            }
         }
+
+        advance();
+        return true;
     }
 
-    void json::parser::parse_object(json *out)
+    // Iterative: open containers are kept in mStack instead of the call stack, so a deeply
+    // nested input is bounded by mOptions.max_depth rather than by the thread's stack size.
+    // Values are written over whatever out already holds, children left over are removed on close
+    bool json::parser::parse_value(json *out)
     {
-        *out = json::object();
+        size_t depth = 0;
 
         while (true)
         {
-            skip_spaces();
-
-            if (*mIt == '\"')
+            // out is the place of the value starting at mIt
+            bool ok;
+            switch (token())
             {
-                step();
+            case '{':
+            case '[': {
+                if (depth == mOptions.max_depth)
+                    return fail(errc::depth_exceeded, mIt);
 
-                // size_t qsize = quote_end_string_size();
-                // json::item* itm = out->create_item(qsize);
+                if (depth == mStack.size())
+                    mStack.resize(depth ? std::min(depth * 2, mOptions.max_depth) : kStackReserve);
 
-                auto str = parse_quote_end_string();
+                value_t type = *mIt == '{' ? value_t::object : value_t::array;
+                if (out->mType != type)
+                    *out = json{type};
+                else if (type == value_t::object)
+                    out->mObject->clear_index(); // reused items are renamed in place
 
-                step_through(':');
-                value_t vt = pending_value();
+                mStack[depth++] = frame{out, 0};
 
-                parse_value(vt, &(*out)[str]);
+                advance();
+                if (token() != (type == value_t::object ? '}' : ']'))
+                {
+                    out = next_child(mStack[depth - 1]);
+                    if (!out)
+                        return false;
 
-                if (mIt == mEnd)
-                    throw ParseError{"Unexpected end of file"};
-            }
-            else if (*mIt == '}')
-            {
-                mIt++;
-                return;
+                    continue;
+                }
+
+                // empty, closed right away
+                ok = close_container(mStack[--depth]);
+                break;
             }
-            else if (*mIt == ',')
-            {
-                step();
+            case '\"':
+                ok = parse_string(out);
+                break;
+            case '-':
+            case '0':
+            case '1':
+            case '2':
+            case '3':
+            case '4':
+            case '5':
+            case '6':
+            case '7':
+            case '8':
+            case '9':
+                ok = parse_number(out);
+                break;
+            case 't':
+            case 'f':
+                ok = parse_boolean(out);
+                break;
+            case 'n':
+                ok = parse_null(out);
+                break;
+            default:
+                return fail(mIt == mEnd ? errc::unexpected_end : errc::invalid_value, mIt);
             }
-            else
+
+            if (!ok)
+                return false;
+
+            // the value is complete: close containers until one continues with ','
+            while (true)
             {
-                throw ParseError{"Unexpected character"};
+                if (!depth)
+                    return true;
+
+                frame &parent = mStack[depth - 1];
+                if (token() == ',')
+                {
+                    advance();
+                    out = next_child(parent);
+                    if (!out)
+                        return false;
+
+                    break;
+                }
+
+                if (token() != (parent.value->is_object() ? '}' : ']'))
+                    return unexpected();
+
+                depth--;
+                if (!close_container(parent))
+                    return false;
             }
         }
     }
 
-    void json::parser::parse_array(json *out)
+    json *json::parser::next_child(frame &parent)
     {
-        *out = json::array();
-        // out->force_array();
+        size_t index = parent.count++;
+        if (parent.value->is_object())
+            return parse_key(parent.value, index);
 
-        skip_spaces(); // TODO: Check is duplicate
-        if (*mIt == ']')
+        auto &values = *parent.value->mArray;
+        return index != values.size() ? &values[index] : &values.emplace_back();
+    }
+
+    // mIt is the closing bracket, reported as the position of a rejected duplicate
+    bool json::parser::close_container(frame &container)
+    {
+        const char *close = mIt;
+        json *out = container.value;
+        if (out->is_object())
         {
-            mIt++;
-            return;
+            while (out->mObject->size() != container.count)
+                out->mObject->pop_back();
         }
-
-        while (true)
+        else
         {
-            value_t vt = pending_value();
-            parse_value(vt, &out->push_back());
+            while (out->mArray->size() != container.count)
+                out->mArray->pop_back();
+        }
 
-            if (mIt == mEnd)
-                throw ParseError{"Unexpected end of file"};
+        advance();
+        if (!out->is_object())
+            return true;
 
-            skip_spaces();
+        if (!resolve_duplicates(out, close))
+            return false;
 
-            if (*mIt == ']')
-            {
-                mIt++;
-                return;
-            }
-
-            if (*mIt == ',')
-            {
-                step();
-            }
-        }
+        out->mObject->reindex();
+        return true;
     }
 
-    void json::parser::parse_string(json *out) { out->assign(parse_quote_end_string()); }
-
-    void json::parser::parse_integer(json *out)
+    json *json::parser::parse_key(json *object, size_t index)
     {
-        bool neg = *mIt == '-';
-        if (neg)
+        if (token() != '\"')
+            return unexpected(), nullptr;
+
+        mIt++;
+        StringViewT name;
+        bool escaped;
+        if (!parse_quote_end_string(name, escaped))
+            return nullptr;
+
+        advance();
+        if (token() != ':')
+            return unexpected(), nullptr;
+
+        advance();
+
+        auto &items = *object->mObject;
+        if (index == items.size())
+            return &object->append_item(make_key(name, escaped));
+
+        // a reused item keeps its key when it is the same pooled text
+        auto &item = items[index];
+        if (mOptions.keys)
         {
-            step();
-            if (!(*mIt >= '0' && *mIt <= '9'))
-                throw ParseError{"Expected integer"};
+            StringViewT pooled = mOptions.keys->intern(name);
+            if (item.key().data() != pooled.data())
+                item.set_name(json_detail::item_key::pooled(pooled));
         }
-
-        int64_t result = *mIt - '0';
-        while (step_check_eof())
+        else if (mOptions.in_situ && !escaped)
         {
-            if ((*mIt >= '0' && *mIt <= '9'))
-                result = result * 10 + (*mIt - '0');
-            else if (*mIt == '.')
-            {
-                float v2 = 0.f;
-
-                do
-                {
-                    if (!step_check_eof())
-                        break;
-                    if (!(*mIt >= '0' && *mIt <= '9'))
-                        break;
+            item.set_name(json_detail::item_key::borrow(name));
+        }
+        else
+        {
+            item.set_name(name);
+        }
 
-                    float divider = 10.f;
+        return &item.value();
+    }
 
-                    v2 += float(*mIt - '0') / divider;
-                    divider *= 10.f;
+    json_detail::item_key json::parser::make_key(StringViewT name, bool escaped)
+    {
+        if (mOptions.keys)
+            return json_detail::item_key::pooled(mOptions.keys->intern(name));
 
-                    while (step_check_eof() && (*mIt >= '0' && *mIt <= '9'))
-                    {
-                        v2 += float(*mIt - '0') / divider;
-                        divider *= 10.f;
-                    }
+        if (mOptions.in_situ && !escaped)
+            return json_detail::item_key::borrow(name);
 
-                } while (false);
+        return json_detail::item_key{name};
+    }
 
-                float rr = float(result) + v2;
-                if (neg)
-                    rr = -rr;
+    bool json::parser::parse_string(json *out)
+    {
+        mIt++; // '"'
+        StringViewT str;
+        bool escaped;
+        if (!parse_quote_end_string(str, escaped))
+            return false;
 
-                out->assign(rr);
-                return;
-            }
-            else
-                break;
+        if (mOptions.in_situ && !escaped)
+        {
+            out->set_borrowed_string(str);
         }
+        else
+        {
+            // a reused place may hold a value the setters don't convert from
+            if (!out->is_string() && !out->is_null())
+                out->assign(value_t::null);
 
-        if (neg)
-            result = -result;
+            out->implicit_set_string(str);
+        }
 
-        out->assign(result);
+        advance();
+        return true;
     }
 
-    void json::parser::parse_boolean(json *out)
+    bool json::parser::parse_number(json *out)
     {
-        if (*mIt == 'r') // t'r'ue
+        if (mOptions.numbers == number_mode::lazy)
         {
-            step();
-            if (*mIt != 'u')
-                throw ParseError{"Invalid 'true' constant"};
+            const char *begin = mIt;
+            size_t int_digits;
+            bool integral;
+            const char *end = json_detail::scan_number(mIt, mEnd, int_digits, integral);
+            if (!end)
+                return fail(errc::invalid_number, mIt);
+
+            mIt = end;
+            if (!finish_atom())
+                return false;
+
+            StringViewT text{begin, size_t(end - begin)};
+            out->set_number_text(text, lazy_number_type(text, int_digits, integral), mOptions.in_situ);
+            return true;
+        }
 
-            step();
-            if (*mIt != 'e')
-                throw ParseError{"Invalid 'true' constant"};
+        json_detail::number num;
+        if (!scan_number(num))
+            return false;
 
-            out->assign(true);
-        }
-        else if (*mIt == 'a') // f'a'lse
-        {
-            step();
-            if (*mIt != 'l')
-                throw ParseError{"Invalid 'false' constant"};
-            step();
-            if (*mIt != 's')
-                throw ParseError{"Invalid 'false' constant"};
-            step();
-            if (*mIt != 'e')
-                throw ParseError{"Invalid 'false' constant"};
+        if (!out->is_number() && !out->is_null())
+            out->assign(value_t::null);
 
-            out->assign(false);
-        }
-        else
+        switch (num.kind)
         {
-            throw ParseError{"Invalid boolean constant"};
+        case json_detail::number_kind::integer:
+            out->assign(num.i);
+            break;
+        case json_detail::number_kind::unsigned_integer:
+            out->assign(num.u);
+            break;
+        default:
+            out->assign(num.d);
+            break;
         }
 
-        mIt++;
+        return true;
     }
 
-    void json::parser::parse_null(json *out)
+    bool json::parser::parse_boolean(json *out)
     {
-        if (*mIt == 'u') // n'u'll
-        {
-            step();
-            if (*mIt != 'l')
-                throw ParseError{"Invalid 'null' constant"};
+        bool value;
+        if (!scan_boolean(value))
+            return false;
+
+        if (!out->is_bool() && !out->is_null())
+            out->assign(value_t::null);
 
-            step();
-            if (*mIt != 'l')
-                throw ParseError{"Invalid 'null' constant"};
+        out->assign(value);
+        return true;
+    }
+
+    bool json::parser::parse_null(json *out)
+    {
+        if (!scan_null())
+            return false;
+
+        if (!out->is_null())
+            out->assign(value_t::null);
+
+        return true;
+    }
+
+    bool json::parser::scan_number(json_detail::number &num)
+    {
+        const char *end = json_detail::parse_number(mIt, mEnd, num);
+        if (!end)
+            return fail(errc::invalid_number, mIt);
+
+        mIt = end;
+        return finish_atom();
+    }
 
-            // it is already null
-            // out->assign(value_t::null);
+    bool json::parser::scan_boolean(bool &value)
+    {
+        size_t left = size_t(mEnd - mIt);
+
+        value = *mIt == 't';
+        if (value)
+        {
+            if (left < 4 || memcmp(mIt, "true", 4) != 0)
+                return fail(errc::invalid_literal, mIt);
+
+            mIt += 4;
         }
         else
         {
-            throw ParseError{"Invalid 'null' constant"};
+            if (left < 5 || memcmp(mIt, "false", 5) != 0)
+                return fail(errc::invalid_literal, mIt);
+
+            mIt += 5;
         }
 
-        mIt++;
+        return finish_atom();
     }
 
-    void json::parser::step_through(char c)
+    bool json::parser::scan_null()
     {
-        skip_spaces();
-        if (*mIt != c)
-            throw ParseError{"Unexpected character"};
+        if (size_t(mEnd - mIt) < 4 || memcmp(mIt, "null", 4) != 0)
+            return fail(errc::invalid_literal, mIt);
 
-        step();
+        mIt += 4;
+        return finish_atom();
     }
 
-    size_t json::parser::quote_end_string_size()
+    // mIt is past the opening quote. Clean runs between escapes are found with
+    // find_quote_or_backslash, validated and copied in bulk. A string without escapes is returned as a view
+    // of the input, otherwise as a view of mEscapeBuffer valid until the next string
+    bool json::parser::parse_quote_end_string(StringViewT &result, bool &escaped)
     {
-        auto oldIt = mIt;
-        size_t size = 0;
+        bool strict = mOptions.strings == string_validation::strict;
 
+        const char *run = mIt;
+        const char *it = json_detail::find_quote_or_backslash(run, mEnd);
+
+        escaped = !(it != mEnd && *it == '\"');
+        if (!escaped)
+        {
+            if (strict && !check_utf8(run, it))
+                return false;
+
+            mIt = it + 1;
+            result = StringViewT{run, size_t(it - run)};
+            return true;
+        }
+
+        size_t size = 0;
         while (true)
         {
-            switch (*mIt)
+            if (it == mEnd)
             {
-            case '\"':
-                mIt = oldIt;
-                return size;
-            case '\\':
-                step();
-                size++;
-                break;
-            default:
-                size++;
+                mIt = mEnd;
+                return fail(errc::unexpected_end, mEnd);
+            }
+
+            // escapes are ascii, so a run never ends inside a valid sequence
+            if (strict && !check_utf8(run, it))
+                return false;
+
+            // room for the run and the longest decoded escape
+            size_t len = size_t(it - run);
+            if (mEscapeBuffer.size() < size + len + 4)
+                mEscapeBuffer.resize((size + len + 4) * 2);
+
+            memcpy(mEscapeBuffer.data() + size, run, len);
+            size += len;
+
+            if (*it == '\"')
                 break;
+
+            const char *escape = it;
+            if (++it == mEnd)
+                continue;
+
+            if (*it == 'u')
+            {
+                if (!decode_unicode_escape(escape, it, size))
+                    return false;
+            }
+            else
+            {
+                char ch;
+                switch (*it)
+                {
+                case 'n':
+                    ch = '\n';
+                    break;
+                case 'r':
+                    ch = '\r';
+                    break;
+                case 't':
+                    ch = '\t';
+                    break;
+                case 'b':
+                    ch = '\b';
+                    break;
+                case 'f':
+                    ch = '\f';
+                    break;
+                case '\"':
+                case '\\':
+                case '/':
+                    ch = *it;
+                    break;
+                default:
+                    if (strict)
+                        return fail(errc::invalid_escape, escape);
+
+                    ch = *it;
+                    break;
+                }
+
+                mEscapeBuffer.data()[size++] = ch;
             }
 
-            step();
+            run = it + 1;
+            it = json_detail::find_quote_or_backslash(run, mEnd);
         }
+
+        mIt = it + 1;
+        result = StringViewT{mEscapeBuffer.data(), size};
+        return true;
     }
 
-    StringT json::parser::parse_quote_end_string()
+    // it is at the 'u' of the escape at escape and is left at its last digit. A high surrogate
+    // takes the \uXXXX of its low one with it. The code point is appended to mEscapeBuffer at size
+    bool json::parser::decode_unicode_escape(const char *escape, const char *&it, size_t &size)
     {
-        size_t size = quote_end_string_size();
-        StringT result(size);
+        int32_t unit = size_t(mEnd - it) > 4 ? json_detail::parse_hex4(it + 1) : -1;
+        if (unit < 0)
+            return fail(errc::invalid_escape, escape);
 
-        auto it = result.data();
+        it += 4;
 
-        while (true)
+        uint32_t cp = uint32_t(unit);
+        if (json_detail::is_high_surrogate(cp) || json_detail::is_low_surrogate(cp))
         {
-            switch (*mIt)
+            int32_t low = -1;
+            if (json_detail::is_high_surrogate(cp) && size_t(mEnd - it) > 6 && it[1] == '\\' && it[2] == 'u')
+                low = json_detail::parse_hex4(it + 3);
+
+            if (low >= 0 && json_detail::is_low_surrogate(uint32_t(low)))
             {
-            case '\"':
-                mIt++;
-                return result;
-            case '\\':
-                step();
-
-                if (*mIt == 'n')
-                    *it = '\n';
-                else if (*mIt == 'r')
-                    *it = '\r';
-                else if (*mIt == 't')
-                    *it = '\t';
-                else if (*mIt == 'b')
-                    *it = '\b';
-                else if (*mIt == 'f')
-                    *it = '\f';
-                else
-                    *it = *mIt;
-                ++it;
+                cp = json_detail::combine_surrogates(cp, uint32_t(low));
+                it += 6;
+            }
+            else if (mOptions.strings == string_validation::strict)
+            {
+                return fail(errc::invalid_escape, escape);
+            }
+            else
+            {
+                cp = json_detail::kReplacementCharacter;
+            }
+        }
+
+        size += json_detail::encode_utf8(cp, mEscapeBuffer.data() + size);
+        return true;
+    }
+
+    bool json::parser::check_utf8(const char *p, const char *end)
+    {
+        const char *invalid = json_detail::find_invalid_utf8(p, end);
+        if (invalid != end)
+            return fail(errc::invalid_utf8, invalid);
+
+        return true;
+    }
+
+    // close: the closing bracket, reported as the position of a rejected duplicate
+    bool json::parser::resolve_duplicates(json *out, const char *close)
+    {
+        auto &items = *out->mObject;
+        size_t size = items.size();
+
+        if (mOptions.duplicates == duplicate_keys::keep_all || size < 2)
+            return true;
+
+        // small objects are cheaper to check pairwise than to hash
+        constexpr size_t kLinearLimit = 8;
+
+        size_t mask = 0;
+        if (size > kLinearLimit)
+        {
+            size_t capacity = 16;
+            while (capacity < size * 2)
+                capacity <<= 1;
+
+            mKeyTable.resize(capacity);
+            memset(mKeyTable.data(), 0, capacity * sizeof(uint32_t));
+            mask = capacity - 1;
+        }
+
+        size_t write = 0;
+        for (size_t read = 0; read != size; read++)
+        {
+            const json_detail::item_key &key = items[read].key();
+
+            size_t found = size;
+            size_t slot = 0;
+            if (mask)
+            {
+                slot = json_detail::hash_key(key.data(), key.size()) & mask;
+                for (; mKeyTable[slot]; slot = (slot + 1) & mask)
+                {
+                    if (items[mKeyTable[slot] - 1].key() == key)
+                    {
+                        found = mKeyTable[slot] - 1;
+                        break;
+                    }
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i != write; i++)
+                {
+                    if (items[i].key() == key)
+                    {
+                        found = i;
+                        break;
+                    }
+                }
+            }
+
+            if (found == size)
+            {
+                if (mask)
+                    mKeyTable[slot] = uint32_t(write + 1);
+                if (read != write)
+                    items[write] = std::move(items[read]);
+                write++;
+                continue;
+            }
+
+            switch (mOptions.duplicates)
+            {
+            case duplicate_keys::reject:
+                return fail(errc::duplicate_key, close);
+            case duplicate_keys::last_wins:
+                items[found].value() = std::move(items[read].value());
                 break;
             default:
-                *it = *mIt;
-                ++it;
                 break;
             }
-
-            step();
         }
-    }
 
-    void json::parser::pending_object()
-    {
-        skip_spaces();
-        if (*mIt != '{')
-            throw ParseError{"Unexpected character"};
+        while (items.size() != write)
+            items.pop_back();
+
+        return true;
     }
 
     void json::parser::set_str(ulib::string_view str)
@@ -436,6 +966,15 @@ namespace ulib
         mIt = str.begin().raw();
         mBegin = str.begin().raw();
         mEnd = str.end().raw();
+
+        mWindow = mBegin;
+        mIndexed = mBegin;
+        mStructuralsCount = 0;
+        mNextStructural = 0;
+        mScanner = {};
+
+        mError = errc::ok;
+        mErrorAt = nullptr;
     }
 
     // void parse(const std::string &str, json &out)
@@ -449,4 +988,4 @@ namespace ulib
     //     parser prsr;
     //     return prsr.parse(str);
     // }
-} // namespace ulib
\ No newline at end of file
+} // namespace ulib
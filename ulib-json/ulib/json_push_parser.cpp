@@ -0,0 +1,439 @@
+#include "json.h"
+#include "json_simd.h"
+#include "json_number.h"
+#include "json_unicode.h"
+
+namespace ulib
+{
+    using StringViewT = typename json::StringViewT;
+    using value_t = typename json::value_t;
+    using errc = typename json::errc;
+    using string_validation = typename json::string_validation;
+    using number_mode = typename json::number_mode;
+
+    static bool is_space(char ch) { return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t'; }
+
+    static bool is_number_char(char ch)
+    {
+        return (ch >= '0' && ch <= '9') || ch == '-' || ch == '+' || ch == '.' || ch == 'e' || ch == 'E';
+    }
+
+    bool json::push_parser::feed(ulib::string_view chunk)
+    {
+        const char *p = chunk.begin().raw();
+        const char *end = chunk.end().raw();
+
+        while (p != end)
+            p = consume(p, end);
+
+        return done();
+    }
+
+    void json::push_parser::finish()
+    {
+        if (mState == state::number && mStack.empty())
+            complete_number();
+
+        if (mState != state::done)
+            throw ParseError{"Unexpected end of file"};
+    }
+
+    json json::push_parser::take()
+    {
+        if (mState != state::done)
+            throw ParseError{"Value is not complete"};
+
+        json result = std::move(mRoot);
+        reset();
+        return result;
+    }
+
+    void json::push_parser::reset()
+    {
+        mRoot = json{};
+        mStack.clear();
+        mHelper.mError = errc::ok;
+        mState = state::value;
+        mTokenSize = 0;
+        mHighSurrogate = 0;
+    }
+
+    // Consumes input from p in the current state, returns where the next state starts
+    const char *json::push_parser::consume(const char *p, const char *end)
+    {
+        switch (mState)
+        {
+        case state::string: {
+            const char *it = json_detail::find_quote_or_backslash(p, end);
+
+            // only another \u may follow a high surrogate
+            if (mHighSurrogate && (it != p || (it != end && *it == '\"')))
+                lone_surrogate();
+
+            append_token(p, size_t(it - p));
+            if (it == end)
+                return end;
+
+            if (*it == '\"')
+                complete_string();
+            else
+                mState = state::escape;
+
+            return it + 1;
+        }
+
+        case state::escape: {
+            if (*p == 'u')
+            {
+                mUnit = 0;
+                mHexDigits = 0;
+                mState = state::unicode;
+                return p + 1;
+            }
+
+            if (mHighSurrogate)
+                lone_surrogate();
+
+            char ch;
+            switch (*p)
+            {
+            case 'n':
+                ch = '\n';
+                break;
+            case 'r':
+                ch = '\r';
+                break;
+            case 't':
+                ch = '\t';
+                break;
+            case 'b':
+                ch = '\b';
+                break;
+            case 'f':
+                ch = '\f';
+                break;
+            case '\"':
+            case '\\':
+            case '/':
+                ch = *p;
+                break;
+            default:
+                if (mHelper.mOptions.strings == string_validation::strict)
+                    throw ParseError{ulib::string{errc_to_string(errc::invalid_escape)}};
+
+                ch = *p;
+                break;
+            }
+
+            append_token(&ch, 1);
+            mState = state::string;
+            return p + 1;
+        }
+
+        case state::unicode:
+            for (; p != end && mHexDigits != 4; p++, mHexDigits++)
+            {
+                int digit = json_detail::hex_digit(*p);
+                if (digit < 0)
+                    throw ParseError{ulib::string{errc_to_string(errc::invalid_escape)}};
+
+                mUnit = (mUnit << 4) | uint32_t(digit);
+            }
+
+            if (mHexDigits == 4)
+            {
+                complete_unicode();
+                mState = state::string;
+            }
+
+            return p;
+
+        case state::literal:
+            for (; p != end && mLiteral[mLiteralPos]; p++, mLiteralPos++)
+            {
+                if (*p != mLiteral[mLiteralPos])
+                    throw ParseError{ulib::string{"Invalid '"} + mLiteral + "' constant"};
+            }
+
+            if (!mLiteral[mLiteralPos])
+            {
+                json *out = slot();
+                if (*mLiteral == 'n')
+                    *out = json{};
+                else
+                    out->assign(*mLiteral == 't');
+
+                complete();
+            }
+
+            return p;
+
+        case state::number: {
+            const char *it = p;
+            while (it != end && is_number_char(*it))
+                it++;
+
+            append_token(p, size_t(it - p));
+            if (it != end)
+                complete_number();
+
+            return it;
+        }
+
+        default:
+            break;
+        }
+
+        while (p != end && is_space(*p))
+            p++;
+        if (p == end)
+            return end;
+
+        char ch = *p;
+        switch (mState)
+        {
+        case state::first_key:
+            if (ch == '}')
+            {
+                close(ch);
+                return p + 1;
+            }
+            [[fallthrough]];
+        case state::key:
+            if (ch != '\"')
+                throw ParseError{"Unexpected character"};
+
+            mStringIsKey = true;
+            mTokenSize = 0;
+            mState = state::string;
+            return p + 1;
+
+        case state::colon:
+            if (ch != ':')
+                throw ParseError{"Unexpected character"};
+
+            mState = state::value;
+            return p + 1;
+
+        case state::next:
+            if (ch == ',')
+                mState = mStack.back()->is_object() ? state::key : state::value;
+            else if (ch == '}' || ch == ']')
+                close(ch);
+            else
+                throw ParseError{"Unexpected character"};
+
+            return p + 1;
+
+        case state::done:
+            throw ParseError{"Unexpected character"};
+
+        case state::first_value:
+            if (ch == ']')
+            {
+                close(ch);
+                return p + 1;
+            }
+            [[fallthrough]];
+        default:
+            break;
+        }
+
+        // state::value
+        switch (ch)
+        {
+        case '{':
+            open(value_t::object);
+            mState = state::first_key;
+            return p + 1;
+        case '[':
+            open(value_t::array);
+            mState = state::first_value;
+            return p + 1;
+        case '\"':
+            mStringIsKey = false;
+            mTokenSize = 0;
+            mState = state::string;
+            return p + 1;
+        case 't':
+            mLiteral = "true";
+            break;
+        case 'f':
+            mLiteral = "false";
+            break;
+        case 'n':
+            mLiteral = "null";
+            break;
+        default:
+            if (ch != '-' && !(ch >= '0' && ch <= '9'))
+                throw ParseError{"Unexpected character"};
+
+            mTokenSize = 0;
+            mState = state::number;
+            return p;
+        }
+
+        mLiteralPos = 0;
+        mState = state::literal;
+        return p;
+    }
+
+    // the place of the value being started: the root, the next array element or the item named mKey
+    json *json::push_parser::slot()
+    {
+        if (mStack.empty())
+            return &mRoot;
+
+        json *parent = mStack.back();
+        if (parent->is_array())
+            return &parent->push_back();
+
+        return &parent->append_item(std::move(mKey));
+    }
+
+    void json::push_parser::open(value_t type)
+    {
+        if (mStack.size() == mHelper.mOptions.max_depth)
+            throw ParseError{ulib::string{errc_to_string(errc::depth_exceeded)}};
+
+        json *out = slot();
+        *out = json(type);
+        mStack.push_back(out);
+    }
+
+    void json::push_parser::close(char bracket)
+    {
+        json *out = mStack.back();
+        if (out->is_object() != (bracket == '}'))
+            throw ParseError{"Unexpected character"};
+
+        if (out->is_object())
+        {
+            if (!mHelper.resolve_duplicates(out, nullptr))
+                throw ParseError{ulib::string{errc_to_string(mHelper.mError)}};
+
+            out->mObject->reindex();
+        }
+
+        mStack.pop_back();
+        complete();
+    }
+
+    void json::push_parser::complete() { mState = mStack.empty() ? state::done : state::next; }
+
+    void json::push_parser::complete_string()
+    {
+        // decoded escapes are valid UTF-8 themselves, so the token is checked as a whole
+        if (mHelper.mOptions.strings == string_validation::strict &&
+            json_detail::find_invalid_utf8(mToken.data(), mToken.data() + mTokenSize) != mToken.data() + mTokenSize)
+            throw ParseError{ulib::string{errc_to_string(errc::invalid_utf8)}};
+
+        StringViewT str{mToken.data(), mTokenSize};
+        if (mStringIsKey)
+        {
+            mKey = mHelper.make_key(str, true);
+            mState = state::colon;
+            return;
+        }
+
+        slot()->implicit_set_string(str);
+        complete();
+    }
+
+    void json::push_parser::complete_unicode()
+    {
+        uint32_t cp = mUnit;
+        if (mHighSurrogate)
+        {
+            if (json_detail::is_low_surrogate(cp))
+            {
+                cp = json_detail::combine_surrogates(mHighSurrogate, cp);
+                mHighSurrogate = 0;
+
+                char utf8[4];
+                append_token(utf8, json_detail::encode_utf8(cp, utf8));
+                return;
+            }
+
+            lone_surrogate();
+        }
+
+        if (json_detail::is_high_surrogate(cp))
+        {
+            mHighSurrogate = cp;
+            return;
+        }
+
+        if (json_detail::is_low_surrogate(cp))
+        {
+            lone_surrogate();
+            return;
+        }
+
+        char utf8[4];
+        append_token(utf8, json_detail::encode_utf8(cp, utf8));
+    }
+
+    void json::push_parser::lone_surrogate()
+    {
+        mHighSurrogate = 0;
+        if (mHelper.mOptions.strings == string_validation::strict)
+            throw ParseError{ulib::string{errc_to_string(errc::invalid_escape)}};
+
+        char utf8[4];
+        append_token(utf8, json_detail::encode_utf8(json_detail::kReplacementCharacter, utf8));
+    }
+
+    void json::push_parser::complete_number()
+    {
+        const char *begin = mToken.data();
+        const char *end = begin + mTokenSize;
+
+        if (mHelper.mOptions.numbers == number_mode::lazy)
+        {
+            size_t int_digits;
+            bool integral;
+            if (json_detail::scan_number(begin, end, int_digits, integral) != end)
+                throw ParseError{"Invalid number"};
+
+            // the token buffer is reused, so the text is always copied
+            StringViewT text{begin, mTokenSize};
+            slot()->set_number_text(text, lazy_number_type(text, int_digits, integral), false);
+            complete();
+            return;
+        }
+
+        json_detail::number num;
+        if (json_detail::parse_number(begin, end, num) != end)
+            throw ParseError{"Invalid number"};
+
+        json *out = slot();
+        switch (num.kind)
+        {
+        case json_detail::number_kind::integer:
+            out->assign(num.i);
+            break;
+        case json_detail::number_kind::unsigned_integer:
+            out->assign(num.u);
+            break;
+        default:
+            out->assign(num.d);
+            break;
+        }
+
+        complete();
+    }
+
+    void json::push_parser::append_token(const char *p, size_t size)
+    {
+        if (!size)
+            return;
+
+        if (mToken.size() < mTokenSize + size)
+            mToken.resize((mTokenSize + size) * 2);
+
+        memcpy(mToken.data() + mTokenSize, p, size);
+        mTokenSize += size;
+    }
+
+} // namespace ulib
@@ -0,0 +1,319 @@
+#include "json.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace ulib
+{
+    using StringViewT = typename json::StringViewT;
+    using errc = typename json::errc;
+
+    constexpr uint32_t kNoState = UINT32_MAX;
+    constexpr uint64_t kNotIndex = UINT64_MAX;
+
+    // canonical array index: "0" or digits without a leading zero
+    static uint64_t token_index(const std::string &token)
+    {
+        if (token.empty() || token.size() > 19 || (token[0] == '0' && token.size() != 1))
+            return kNotIndex;
+
+        uint64_t index = 0;
+        for (char ch : token)
+        {
+            if (ch < '0' || ch > '9')
+                return kNotIndex;
+
+            index = index * 10 + uint64_t(ch - '0');
+        }
+
+        return index;
+    }
+
+    struct json::path_set::automaton
+    {
+        // trie of the pointers as added
+        struct node
+        {
+            std::map<std::string, uint32_t> keys;
+            uint32_t wildcard = kNoState;
+            // pointers ending here
+            std::vector<uint32_t> ends;
+        };
+
+        struct edge
+        {
+            std::string name;
+            uint64_t index;
+            uint32_t target;
+        };
+
+        // the trie nodes a path of the document can be in at once, wildcards and keys overlap
+        struct state
+        {
+            std::vector<edge> edges;
+            // keys and indices not in edges
+            uint32_t other = kNoState;
+            std::vector<uint32_t> matches;
+
+            bool leaf() const { return edges.empty() && other == kNoState; }
+
+            uint32_t find(StringViewT key) const
+            {
+                for (auto &e : edges)
+                    if (e.name.size() == key.size() && memcmp(e.name.data(), key.data(), key.size()) == 0)
+                        return e.target;
+
+                return other;
+            }
+
+            uint32_t find(uint64_t index) const
+            {
+                for (auto &e : edges)
+                    if (e.index == index)
+                        return e.target;
+
+                return other;
+            }
+        };
+
+        // subset construction over the trie, states[0] is the document root
+        void compile()
+        {
+            states.clear();
+
+            std::map<std::vector<uint32_t>, uint32_t> ids;
+            std::vector<std::vector<uint32_t>> sets;
+            auto id = [&](std::vector<uint32_t> set) {
+                if (set.empty())
+                    return kNoState;
+
+                std::sort(set.begin(), set.end());
+                set.erase(std::unique(set.begin(), set.end()), set.end());
+
+                auto it = ids.emplace(set, uint32_t(sets.size()));
+                if (it.second)
+                    sets.push_back(set);
+
+                return it.first->second;
+            };
+
+            id({0});
+            for (size_t i = 0; i != sets.size(); i++)
+            {
+                std::vector<uint32_t> set = sets[i];
+                std::vector<uint32_t> wildcards;
+                std::set<std::string> names;
+
+                state out;
+                for (uint32_t n : set)
+                {
+                    const node &trie = nodes[n];
+                    if (trie.wildcard != kNoState)
+                        wildcards.push_back(trie.wildcard);
+
+                    out.matches.insert(out.matches.end(), trie.ends.begin(), trie.ends.end());
+                    for (auto &key : trie.keys)
+                        names.insert(key.first);
+                }
+
+                for (auto &name : names)
+                {
+                    std::vector<uint32_t> next = wildcards;
+                    for (uint32_t n : set)
+                    {
+                        auto it = nodes[n].keys.find(name);
+                        if (it != nodes[n].keys.end())
+                            next.push_back(it->second);
+                    }
+
+                    out.edges.push_back(edge{name, token_index(name), id(next)});
+                }
+
+                out.other = id(wildcards);
+                std::sort(out.matches.begin(), out.matches.end());
+                states.push_back(std::move(out));
+            }
+        }
+
+        std::vector<node> nodes{1};
+        std::vector<state> states;
+        size_t pointers = 0;
+    };
+
+    json::path_set::path_set() : mAutomaton(std::make_unique<automaton>()) { mAutomaton->compile(); }
+
+    json::path_set::path_set(std::initializer_list<StringViewT> pointers) : path_set()
+    {
+        for (auto pointer : pointers)
+            add(pointer);
+    }
+
+    json::path_set::path_set(path_set &&other) = default;
+    json::path_set &json::path_set::operator=(path_set &&other) = default;
+    json::path_set::~path_set() = default;
+
+    size_t json::path_set::add(StringViewT pointer)
+    {
+        const char *p = pointer.data();
+        const char *end = p + pointer.size();
+        if (p != end && *p != '/')
+            throw exception{ulib::string{"json pointer must start with '/': "} + pointer};
+
+        // tokens are unescaped before the trie is touched, a malformed pointer leaves it as is
+        std::vector<std::string> tokens;
+        while (p != end)
+        {
+            std::string &token = tokens.emplace_back();
+            for (p++; p != end && *p != '/'; p++)
+            {
+                if (*p != '~')
+                {
+                    token += *p;
+                    continue;
+                }
+
+                if (++p == end || (*p != '0' && *p != '1'))
+                    throw exception{ulib::string{"json pointer has an invalid escape: "} + pointer};
+
+                token += *p == '0' ? '~' : '/';
+            }
+        }
+
+        automaton &a = *mAutomaton;
+        uint32_t n = 0;
+        for (auto &token : tokens)
+        {
+            uint32_t next = token == "*" ? a.nodes[n].wildcard : kNoState;
+            if (token != "*")
+            {
+                auto it = a.nodes[n].keys.find(token);
+                if (it != a.nodes[n].keys.end())
+                    next = it->second;
+            }
+
+            if (next == kNoState)
+            {
+                next = uint32_t(a.nodes.size());
+                if (token == "*")
+                    a.nodes[n].wildcard = next;
+                else
+                    a.nodes[n].keys.emplace(token, next);
+
+                a.nodes.emplace_back();
+            }
+
+            n = next;
+        }
+
+        size_t index = a.pointers++;
+        a.nodes[n].ends.push_back(uint32_t(index));
+        a.compile();
+        return index;
+    }
+
+    size_t json::path_set::size() const { return mAutomaton->pointers; }
+
+    size_t json::parser::select(ulib::string_view str, const path_set &paths,
+                                const std::function<bool(size_t, json &)> &callback)
+    {
+        set_str(str);
+        advance();
+
+        size_t delivered = 0;
+        if (!select_value(paths, 0, callback, delivered) && mError != errc::ok)
+            throw ParseError{ulib::string{errc_to_string(mError)}};
+
+        return delivered;
+    }
+
+    // Recursion only follows the pointers, so it is bounded by the longest of them
+    // rather than by the nesting of the document
+    bool json::parser::select_value(const path_set &paths, uint32_t state,
+                                    const std::function<bool(size_t, json &)> &callback, size_t &delivered)
+    {
+        const auto &s = paths.mAutomaton->states[state];
+        if (!s.matches.empty())
+        {
+            const char *start = mIt;
+            json value;
+            if (!parse_value(&value))
+                return false;
+
+            for (uint32_t index : s.matches)
+            {
+                delivered++;
+                if (!callback(index, value))
+                    return false;
+            }
+
+            if (s.leaf())
+                return true;
+
+            // pointers below a delivered value are matched on a second pass over it
+            seek(start);
+        }
+
+        char open = token();
+        if (open != '{' && open != '[')
+            return skip_value();
+
+        bool object = open == '{';
+        char close = object ? '}' : ']';
+
+        advance();
+        if (token() == close)
+        {
+            advance();
+            return true;
+        }
+
+        for (uint64_t index = 0;; index++)
+        {
+            uint32_t next;
+            if (object)
+            {
+                if (token() != '\"')
+                    return unexpected();
+
+                mIt++;
+                StringViewT key;
+                bool escaped;
+                if (!parse_quote_end_string(key, escaped))
+                    return false;
+
+                advance();
+                if (token() != ':')
+                    return unexpected();
+
+                advance();
+                next = s.find(key);
+            }
+            else
+            {
+                next = s.find(index);
+            }
+
+            bool ok = next == kNoState ? skip_value() : select_value(paths, next, callback, delivered);
+            if (!ok)
+                return false;
+
+            if (token() == ',')
+            {
+                advance();
+            }
+            else if (token() == close)
+            {
+                advance();
+                return true;
+            }
+            else
+            {
+                return unexpected();
+            }
+        }
+    }
+
+} // namespace ulib
@@ -2,6 +2,9 @@
 
 #include <fops/i64toa_10_inl.h>
 
+#include <charconv>
+#include <cmath>
+
 namespace ulib
 {
     namespace json_detail
@@ -9,6 +12,31 @@ namespace ulib
         using StringViewT = typename json::StringViewT;
         using value_t = typename json::value_t;
 
+        // the longest shortest round trip form of a double, "-1.2345678901234567e-308", and ".0"
+        constexpr size_t kMaxDoubleLength = 32;
+
+        // Shortest text that parses back to the same double. Integral values get ".0" so they are
+        // read back as floating, json has no infinity or NaN so non-finite values are written as null
+        static char *write_double(double d, char *out)
+        {
+            if (!std::isfinite(d))
+            {
+                memcpy(out, "null", 4);
+                return out + 4;
+            }
+
+            char *begin = out;
+            out = std::to_chars(out, out + kMaxDoubleLength, d).ptr;
+            for (const char *it = begin; it != out; it++)
+            {
+                if (*it == '.' || *it == 'e')
+                    return out;
+            }
+
+            memcpy(out, ".0", 2);
+            return out + 2;
+        }
+
         size_t serialized_object_length(const json &obj);
         size_t serialized_array_length(const json &obj);
         size_t serialized_length(const json &obj);
@@ -64,6 +92,10 @@ namespace ulib
             size_t result = 0;
             int64_t x, n;
 
+            // numbers parsed with number_mode::lazy are written as they were read
+            if (auto text = obj.number_text(); !text.empty())
+                return text.size();
+
             switch (obj.type())
             {
             case value_t::integer:
@@ -74,9 +106,20 @@ namespace ulib
                 result += n;
                 break;
 
-            case value_t::floating:
-                result += std::to_string(obj.get<float>()).length();
-                break;
+            case value_t::unsigned_integer: {
+                uint64_t u = obj.get<uint64_t>();
+                n = 1;
+                while ((u /= 10) != 0)
+                    n++;
+                result += n;
+            }
+            break;
+
+            case value_t::floating: {
+                char buffer[kMaxDoubleLength];
+                result += size_t(write_double(obj.get<double>(), buffer) - buffer);
+            }
+            break;
 
             case value_t::string:
 
@@ -200,6 +243,12 @@ namespace ulib
             size_t i64len;
             char i64buf[21];
 
+            if (auto text = obj.number_text(); !text.empty())
+            {
+                memcpy(out, text.data(), text.size());
+                return out + text.size();
+            }
+
             switch (obj.type())
             {
             case value_t::integer: {
@@ -209,12 +258,13 @@ namespace ulib
             }
             break;
 
-            case value_t::floating: {
-                std::string str = std::to_string(obj.get<float>());
-                memcpy(out, str.data(), str.size());
-                out += str.size();
-            }
-            break;
+            case value_t::unsigned_integer:
+                out = std::to_chars(out, out + 20, obj.get<uint64_t>()).ptr;
+                break;
+
+            case value_t::floating:
+                out = write_double(obj.get<double>(), out);
+                break;
 
             case value_t::string:
 
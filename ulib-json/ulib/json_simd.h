@@ -0,0 +1,522 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ULIB_JSON_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ULIB_JSON_SSE2
+#endif
+
+#if defined(ULIB_JSON_AVX2) || (defined(ULIB_JSON_SSE2) && defined(__SSSE3__))
+#include <tmmintrin.h>
+#define ULIB_JSON_SSSE3
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Stage 1 of the parser: classifies the input 64 bytes at a time into bitmasks
+// and turns them into the positions of structural characters. Stage 2 (json::parser)
+// then jumps between these positions instead of walking the input byte by byte.
+
+namespace ulib
+{
+    namespace json_detail
+    {
+        constexpr uint64_t kOddBits = 0xAAAAAAAAAAAAAAAAULL;
+
+        inline int trailing_zeroes(uint64_t v)
+        {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+            unsigned long idx;
+            _BitScanForward64(&idx, v);
+            return int(idx);
+#elif defined(_MSC_VER)
+            unsigned long idx;
+            if (_BitScanForward(&idx, uint32_t(v)))
+                return int(idx);
+            _BitScanForward(&idx, uint32_t(v >> 32));
+            return int(idx) + 32;
+#else
+            return __builtin_ctzll(v);
+#endif
+        }
+
+        // Bit i of the result is the xor of bits [0, i] of v: turns quote positions into an in-string mask
+        inline uint64_t prefix_xor(uint64_t v)
+        {
+            v ^= v << 1;
+            v ^= v << 2;
+            v ^= v << 4;
+            v ^= v << 8;
+            v ^= v << 16;
+            v ^= v << 32;
+            return v;
+        }
+
+        struct block64
+        {
+#if defined(ULIB_JSON_AVX2)
+            __m256i lo, hi;
+
+            explicit block64(const char *p)
+                : lo(_mm256_loadu_si256((const __m256i *)p)), hi(_mm256_loadu_si256((const __m256i *)(p + 32)))
+            {
+            }
+
+            static uint64_t mask(__m256i l, __m256i h)
+            {
+                return uint64_t(uint32_t(_mm256_movemask_epi8(l))) | (uint64_t(uint32_t(_mm256_movemask_epi8(h))) << 32);
+            }
+
+            uint64_t eq(char c) const
+            {
+                __m256i v = _mm256_set1_epi8(c);
+                return mask(_mm256_cmpeq_epi8(lo, v), _mm256_cmpeq_epi8(hi, v));
+            }
+
+            // matches both cases of an ascii pair that differs only in bit 0x20: '[' and '{', ']' and '}'
+            uint64_t eq_lower(char c) const
+            {
+                __m256i v = _mm256_set1_epi8(c);
+                __m256i bit = _mm256_set1_epi8(0x20);
+                return mask(_mm256_cmpeq_epi8(_mm256_or_si256(lo, bit), v), _mm256_cmpeq_epi8(_mm256_or_si256(hi, bit), v));
+            }
+#elif defined(ULIB_JSON_SSE2)
+            __m128i v0, v1, v2, v3;
+
+            explicit block64(const char *p)
+                : v0(_mm_loadu_si128((const __m128i *)p)), v1(_mm_loadu_si128((const __m128i *)(p + 16))),
+                  v2(_mm_loadu_si128((const __m128i *)(p + 32))), v3(_mm_loadu_si128((const __m128i *)(p + 48)))
+            {
+            }
+
+            static uint64_t mask(__m128i a, __m128i b, __m128i c, __m128i d)
+            {
+                return uint64_t(uint32_t(_mm_movemask_epi8(a))) | (uint64_t(uint32_t(_mm_movemask_epi8(b))) << 16) |
+                       (uint64_t(uint32_t(_mm_movemask_epi8(c))) << 32) |
+                       (uint64_t(uint32_t(_mm_movemask_epi8(d))) << 48);
+            }
+
+            uint64_t eq(char c) const
+            {
+                __m128i v = _mm_set1_epi8(c);
+                return mask(_mm_cmpeq_epi8(v0, v), _mm_cmpeq_epi8(v1, v), _mm_cmpeq_epi8(v2, v),
+                            _mm_cmpeq_epi8(v3, v));
+            }
+
+            uint64_t eq_lower(char c) const
+            {
+                __m128i v = _mm_set1_epi8(c);
+                __m128i bit = _mm_set1_epi8(0x20);
+                return mask(_mm_cmpeq_epi8(_mm_or_si128(v0, bit), v), _mm_cmpeq_epi8(_mm_or_si128(v1, bit), v),
+                            _mm_cmpeq_epi8(_mm_or_si128(v2, bit), v), _mm_cmpeq_epi8(_mm_or_si128(v3, bit), v));
+            }
+#else
+            const unsigned char *bytes;
+
+            explicit block64(const char *p) : bytes((const unsigned char *)p) {}
+
+            uint64_t eq(char c) const
+            {
+                uint64_t result = 0;
+                for (int i = 0; i < 64; i++)
+                    result |= uint64_t(bytes[i] == (unsigned char)c) << i;
+                return result;
+            }
+
+            uint64_t eq_lower(char c) const
+            {
+                uint64_t result = 0;
+                for (int i = 0; i < 64; i++)
+                    result |= uint64_t((bytes[i] | 0x20) == (unsigned char)c) << i;
+                return result;
+            }
+#endif
+
+            uint64_t whitespace() const { return eq(' ') | eq('\t') | eq('\n') | eq('\r'); }
+            uint64_t op() const { return eq_lower('{') | eq_lower('}') | eq(':') | eq(','); }
+        };
+
+        // Given the backslashes of a block, returns the characters escaped by them.
+        // Runs of backslashes are resolved by parity; a run crossing the block end is carried in prev_escaped.
+        inline uint64_t escaped_chars(uint64_t backslash, uint64_t &prev_escaped)
+        {
+            if (!backslash)
+            {
+                uint64_t escaped = prev_escaped;
+                prev_escaped = 0;
+                return escaped;
+            }
+
+            uint64_t potential_escape = backslash & ~prev_escaped;
+            uint64_t maybe_escaped = potential_escape << 1;
+            uint64_t escape_and_terminal_code = ((maybe_escaped | kOddBits) - potential_escape) ^ kOddBits;
+
+            uint64_t escaped = escape_and_terminal_code ^ (backslash | prev_escaped);
+            uint64_t escape = escape_and_terminal_code & backslash;
+            prev_escaped = escape >> 63;
+            return escaped;
+        }
+
+        struct scanner
+        {
+            // Returns the structural characters of the block: operators, opening quotes
+            // and the first byte of every scalar (numbers and literals) outside of strings.
+            static uint64_t next(const char *p, json_detail::scanner_state &state)
+            {
+                block64 in(p);
+
+                uint64_t escaped = escaped_chars(in.eq('\\'), state.prev_escaped);
+                uint64_t quote = in.eq('\"') & ~escaped;
+
+                uint64_t in_string = prefix_xor(quote) ^ state.prev_in_string;
+                state.prev_in_string = uint64_t(int64_t(in_string) >> 63);
+
+                uint64_t op = in.op();
+                uint64_t scalar = ~(op | in.whitespace());
+                uint64_t nonquote_scalar = scalar & ~quote;
+                uint64_t follows_nonquote_scalar = (nonquote_scalar << 1) | state.prev_scalar;
+                state.prev_scalar = nonquote_scalar >> 63;
+
+                // string_tail: everything inside a string except the opening quote
+                uint64_t string_tail = in_string ^ quote;
+                return (op | quote | (scalar & ~follows_nonquote_scalar)) & ~string_tail;
+            }
+        };
+
+        inline int popcount(uint64_t v)
+        {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+            return int(__popcnt64(v));
+#elif defined(_MSC_VER)
+            return int(__popcnt(uint32_t(v)) + __popcnt(uint32_t(v >> 32)));
+#else
+            return __builtin_popcountll(v);
+#endif
+        }
+
+        // Returns the bracket that closes depth open containers, scanning from p in the string state
+        // stage 1 left there, or nullptr if they aren't closed before end. Brackets inside strings are
+        // masked like in scanner::next, and a block without enough closing brackets to reach depth 0 is
+        // passed with two popcounts. Bracket kinds aren't matched against each other
+        inline const char *find_container_end(const char *p, const char *end, scanner_state state, size_t open_depth)
+        {
+            int64_t depth = int64_t(open_depth);
+
+            while (p != end)
+            {
+                const char *base = p;
+                char block[64];
+                if (end - p < 64)
+                {
+                    // the tail is padded with spaces so the block load never reads past the input
+                    memset(block, ' ', sizeof(block));
+                    memcpy(block, p, size_t(end - p));
+                    base = block;
+                }
+
+                block64 in(base);
+                uint64_t escaped = escaped_chars(in.eq('\\'), state.prev_escaped);
+                uint64_t quote = in.eq('\"') & ~escaped;
+                uint64_t in_string = prefix_xor(quote) ^ state.prev_in_string;
+                state.prev_in_string = uint64_t(int64_t(in_string) >> 63);
+
+                uint64_t open = in.eq_lower('{') & ~in_string;
+                uint64_t close = in.eq_lower('}') & ~in_string;
+
+                int closes = popcount(close);
+                if (closes < depth)
+                {
+                    depth += popcount(open) - closes;
+                }
+                else
+                {
+                    for (uint64_t bits = open | close; bits; bits &= bits - 1)
+                    {
+                        uint64_t bit = bits & (0 - bits);
+                        depth += (open & bit) ? 1 : -1;
+                        if (!depth)
+                            return p + trailing_zeroes(bit);
+                    }
+                }
+
+                p = end - p < 64 ? end : p + 64;
+            }
+
+            return nullptr;
+        }
+
+        // Returns the first '"' or '\\' in [p, end), or end
+        inline const char *find_quote_or_backslash(const char *p, const char *end)
+        {
+#if defined(ULIB_JSON_AVX2)
+            const __m256i quote32 = _mm256_set1_epi8('\"');
+            const __m256i backslash32 = _mm256_set1_epi8('\\');
+            for (; end - p >= 32; p += 32)
+            {
+                __m256i v = _mm256_loadu_si256((const __m256i *)p);
+                uint32_t mask = uint32_t(_mm256_movemask_epi8(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, quote32), _mm256_cmpeq_epi8(v, backslash32))));
+                if (mask)
+                    return p + trailing_zeroes(mask);
+            }
+#endif
+#if defined(ULIB_JSON_AVX2) || defined(ULIB_JSON_SSE2)
+            const __m128i quote16 = _mm_set1_epi8('\"');
+            const __m128i backslash16 = _mm_set1_epi8('\\');
+            for (; end - p >= 16; p += 16)
+            {
+                __m128i v = _mm_loadu_si128((const __m128i *)p);
+                uint32_t mask = uint32_t(
+                    _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, quote16), _mm_cmpeq_epi8(v, backslash16))));
+                if (mask)
+                    return p + trailing_zeroes(mask);
+            }
+#elif !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            // swar: flags the bytes of a word equal to '"' or '\\', the lowest flag is exact
+            constexpr uint64_t ones = 0x0101010101010101ULL;
+            constexpr uint64_t highs = 0x8080808080808080ULL;
+            for (; end - p >= 8; p += 8)
+            {
+                uint64_t v;
+                memcpy(&v, p, 8);
+
+                uint64_t q = v ^ (ones * '\"');
+                uint64_t b = v ^ (ones * '\\');
+                uint64_t mask = (((q - ones) & ~q) | ((b - ones) & ~b)) & highs;
+                if (mask)
+                    return p + trailing_zeroes(mask) / 8;
+            }
+#endif
+            for (; p != end; p++)
+            {
+                if (*p == '\"' || *p == '\\')
+                    return p;
+            }
+
+            return end;
+        }
+
+        // Returns the start of the first malformed sequence in [p, end), or end. Rejects overlong
+        // forms, surrogates, code points above U+10FFFF and sequences cut by end
+        inline const char *find_invalid_utf8_scalar(const char *p, const char *end)
+        {
+            while (p != end)
+            {
+                unsigned char c = (unsigned char)*p;
+                if (c < 0x80)
+                {
+                    p++;
+                    continue;
+                }
+
+                size_t len;
+                uint32_t min;
+                if ((c & 0xE0) == 0xC0)
+                    len = 2, min = 0x80;
+                else if ((c & 0xF0) == 0xE0)
+                    len = 3, min = 0x800;
+                else if ((c & 0xF8) == 0xF0)
+                    len = 4, min = 0x10000;
+                else
+                    return p;
+
+                if (size_t(end - p) < len)
+                    return p;
+
+                uint32_t cp = c & (0x7F >> len);
+                for (size_t i = 1; i != len; i++)
+                {
+                    unsigned char next = (unsigned char)p[i];
+                    if ((next & 0xC0) != 0x80)
+                        return p;
+
+                    cp = (cp << 6) | (next & 0x3F);
+                }
+
+                if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+                    return p;
+
+                p += len;
+            }
+
+            return end;
+        }
+
+#if defined(ULIB_JSON_SSSE3)
+        // Keiser-Lemire lookup validation, 16 bytes at a time. Three table lookups classify every
+        // byte pair by the high nibble of the first byte, its low nibble and the high nibble of the
+        // second one; a bit set in all three is an error. Continuations of 3 and 4 byte sequences
+        // are then checked against the leads two and three bytes back
+        struct utf8_checker
+        {
+            static constexpr uint8_t kTooShort = 1 << 0;
+            static constexpr uint8_t kTooLong = 1 << 1;
+            static constexpr uint8_t kOverlong3 = 1 << 2;
+            static constexpr uint8_t kTooLarge = 1 << 3;
+            static constexpr uint8_t kSurrogate = 1 << 4;
+            static constexpr uint8_t kOverlong2 = 1 << 5;
+            static constexpr uint8_t kTooLarge1000 = 1 << 6;
+            static constexpr uint8_t kOverlong4 = 1 << 6;
+            static constexpr uint8_t kTwoConts = 1 << 7;
+            static constexpr uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+            static __m128i high_nibbles(__m128i v) { return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F)); }
+
+            static __m128i special_cases(__m128i input, __m128i prev1)
+            {
+                const __m128i byte1_high_table =
+                    _mm_setr_epi8(kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+                                  char(kTwoConts), char(kTwoConts), char(kTwoConts), char(kTwoConts),
+                                  kTooShort | kOverlong2, kTooShort, kTooShort | kOverlong3 | kSurrogate,
+                                  kTooShort | kTooLarge | kTooLarge1000 | kOverlong4);
+
+                const __m128i byte1_low_table = _mm_setr_epi8(
+                    char(kCarry | kOverlong3 | kOverlong2 | kOverlong4), char(kCarry | kOverlong2), char(kCarry),
+                    char(kCarry), char(kCarry | kTooLarge), char(kCarry | kTooLarge | kTooLarge1000),
+                    char(kCarry | kTooLarge | kTooLarge1000), char(kCarry | kTooLarge | kTooLarge1000),
+                    char(kCarry | kTooLarge | kTooLarge1000), char(kCarry | kTooLarge | kTooLarge1000),
+                    char(kCarry | kTooLarge | kTooLarge1000), char(kCarry | kTooLarge | kTooLarge1000),
+                    char(kCarry | kTooLarge | kTooLarge1000), char(kCarry | kTooLarge | kTooLarge1000 | kSurrogate),
+                    char(kCarry | kTooLarge | kTooLarge1000), char(kCarry | kTooLarge | kTooLarge1000));
+
+                const __m128i byte2_high_table = _mm_setr_epi8(
+                    kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+                    char(kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4),
+                    char(kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge),
+                    char(kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge),
+                    char(kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge), kTooShort, kTooShort,
+                    kTooShort, kTooShort);
+
+                __m128i byte1_high = _mm_shuffle_epi8(byte1_high_table, high_nibbles(prev1));
+                __m128i byte1_low = _mm_shuffle_epi8(byte1_low_table, _mm_and_si128(prev1, _mm_set1_epi8(0x0F)));
+                __m128i byte2_high = _mm_shuffle_epi8(byte2_high_table, high_nibbles(input));
+                return _mm_and_si128(_mm_and_si128(byte1_high, byte1_low), byte2_high);
+            }
+
+            // error bits of input, prev is the block before it
+            static __m128i check(__m128i input, __m128i prev)
+            {
+                __m128i prev1 = _mm_alignr_epi8(input, prev, 15);
+                __m128i prev2 = _mm_alignr_epi8(input, prev, 14);
+                __m128i prev3 = _mm_alignr_epi8(input, prev, 13);
+
+                __m128i special = special_cases(input, prev1);
+
+                // 3rd byte of a sequence led by 0b1110____ or later, 4th byte of one led by 0b11110___
+                __m128i third = _mm_subs_epu8(prev2, _mm_set1_epi8(char(0xE0 - 1)));
+                __m128i fourth = _mm_subs_epu8(prev3, _mm_set1_epi8(char(0xF0 - 1)));
+                __m128i must_be_continuation = _mm_cmpgt_epi8(_mm_or_si128(third, fourth), _mm_setzero_si128());
+
+                return _mm_xor_si128(_mm_and_si128(must_be_continuation, _mm_set1_epi8(char(0x80))), special);
+            }
+
+            // nonzero when the block ends inside a sequence
+            static __m128i incomplete(__m128i input)
+            {
+                const __m128i max = _mm_setr_epi8(char(0xFF), char(0xFF), char(0xFF), char(0xFF), char(0xFF),
+                                                  char(0xFF), char(0xFF), char(0xFF), char(0xFF), char(0xFF),
+                                                  char(0xFF), char(0xFF), char(0xFF), char(0xF0 - 1),
+                                                  char(0xE0 - 1), char(0xC0 - 1));
+                return _mm_subs_epu8(input, max);
+            }
+        };
+#endif
+
+        // Returns the start of the first malformed UTF-8 sequence in [p, end), or end.
+        // Ascii is skipped in bulk, the vector path only finds out whether there is an error
+        // and the scalar one locates it
+        inline const char *find_invalid_utf8(const char *p, const char *end)
+        {
+#if defined(ULIB_JSON_SSE2) || defined(ULIB_JSON_AVX2)
+            for (; end - p >= 16; p += 16)
+            {
+                if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)p)))
+                    break;
+            }
+#endif
+            constexpr uint64_t highs = 0x8080808080808080ULL;
+            for (; end - p >= 8; p += 8)
+            {
+                uint64_t v;
+                memcpy(&v, p, 8);
+                if (v & highs)
+                    break;
+            }
+
+            while (p != end && (unsigned char)*p < 0x80)
+                p++;
+
+            // most strings end here
+            if (p == end)
+                return end;
+
+#if defined(ULIB_JSON_SSSE3)
+            // p is at the first non ascii byte, so at a character boundary
+            const char *start = p;
+            __m128i error = _mm_setzero_si128();
+            __m128i prev = _mm_setzero_si128();
+            __m128i prev_incomplete = _mm_setzero_si128();
+
+            for (; end - p >= 16; p += 16)
+            {
+                __m128i input = _mm_loadu_si128((const __m128i *)p);
+                if (!_mm_movemask_epi8(input))
+                {
+                    error = _mm_or_si128(error, prev_incomplete);
+                    prev_incomplete = _mm_setzero_si128();
+                }
+                else
+                {
+                    error = _mm_or_si128(error, utf8_checker::check(input, prev));
+                    prev_incomplete = utf8_checker::incomplete(input);
+                }
+
+                prev = input;
+            }
+
+            if (p != end)
+            {
+                // zero padding is ascii, so a sequence cut by end is reported as too short
+                char block[16] = {};
+                memcpy(block, p, size_t(end - p));
+
+                __m128i input = _mm_loadu_si128((const __m128i *)block);
+                error = _mm_or_si128(error, utf8_checker::check(input, prev));
+            }
+            else
+            {
+                error = _mm_or_si128(error, prev_incomplete);
+            }
+
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF)
+                return end;
+
+            return find_invalid_utf8_scalar(start, end);
+#else
+            return find_invalid_utf8_scalar(p, end);
+#endif
+        }
+
+        // Writes offsets of set bits (plus base) to out, returns count
+        inline size_t flatten_bits(uint64_t bits, uint32_t base, uint32_t *out)
+        {
+            size_t n = 0;
+            while (bits)
+            {
+                out[n++] = base + uint32_t(trailing_zeroes(bits));
+                bits &= bits - 1;
+            }
+
+            return n;
+        }
+
+    } // namespace json_detail
+} // namespace ulib
@@ -0,0 +1,496 @@
+#pragma once
+
+#include "json.h"
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Describes the public members of a struct for json::parser::parse_into, each read from the key of
+// the same name. Used at namespace scope, next to the struct:
+//
+//     struct point { int x; int y; std::optional<ulib::string> label; };
+//     ULIB_JSON_STRUCT(point, x, y, label)
+//
+// Keys that differ from the member names are described by defining the function the macro defines:
+//
+//     constexpr auto ulib_json_fields(const point *)
+//     {
+//         return std::make_tuple(ulib::json_field("X", &point::x), ulib::json_field("Y", &point::y));
+//     }
+#define ULIB_JSON_STRUCT(type, ...)                                                                     \
+    constexpr auto ulib_json_fields(const type *)                                                       \
+    {                                                                                                   \
+        return std::make_tuple(ULIB_JSON_FOR_EACH(ULIB_JSON_FIELD_OF, type, __VA_ARGS__));              \
+    }
+
+#define ULIB_JSON_FIELD_OF(type, member) ::ulib::json_field(#member, &type::member)
+
+#define ULIB_JSON_EXPAND(x) x
+#define ULIB_JSON_FE_1(m, t, a) m(t, a)
+#define ULIB_JSON_FE_2(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_1(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_3(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_2(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_4(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_3(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_5(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_4(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_6(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_5(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_7(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_6(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_8(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_7(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_9(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_8(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_10(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_9(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_11(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_10(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_12(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_11(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_13(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_12(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_14(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_13(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_15(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_14(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_16(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_15(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_17(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_16(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_18(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_17(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_19(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_18(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_20(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_19(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_21(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_20(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_22(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_21(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_23(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_22(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_24(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_23(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_25(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_24(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_26(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_25(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_27(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_26(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_28(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_27(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_29(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_28(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_30(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_29(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_31(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_30(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_32(m, t, a, ...) m(t, a), ULIB_JSON_EXPAND(ULIB_JSON_FE_31(m, t, __VA_ARGS__))
+#define ULIB_JSON_FE_N(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
+#define ULIB_JSON_FOR_EACH(m, t, ...)                                                                   \
+    ULIB_JSON_EXPAND(ULIB_JSON_FE_N(__VA_ARGS__, ULIB_JSON_FE_32, ULIB_JSON_FE_31, ULIB_JSON_FE_30, ULIB_JSON_FE_29, ULIB_JSON_FE_28, ULIB_JSON_FE_27, ULIB_JSON_FE_26, ULIB_JSON_FE_25, ULIB_JSON_FE_24, ULIB_JSON_FE_23, ULIB_JSON_FE_22, ULIB_JSON_FE_21, ULIB_JSON_FE_20, ULIB_JSON_FE_19, ULIB_JSON_FE_18, ULIB_JSON_FE_17, ULIB_JSON_FE_16, ULIB_JSON_FE_15, ULIB_JSON_FE_14, ULIB_JSON_FE_13, ULIB_JSON_FE_12, ULIB_JSON_FE_11, ULIB_JSON_FE_10, ULIB_JSON_FE_9, ULIB_JSON_FE_8, ULIB_JSON_FE_7, ULIB_JSON_FE_6, ULIB_JSON_FE_5, ULIB_JSON_FE_4, ULIB_JSON_FE_3, ULIB_JSON_FE_2, ULIB_JSON_FE_1)(m, t, __VA_ARGS__))
+
+namespace ulib
+{
+    namespace json_detail
+    {
+        template <class S, class M>
+        struct field
+        {
+            const char *name;
+            size_t size;
+            M S::*member;
+        };
+
+        // Digest of a key from its length and first, middle and last characters, so telling keys apart
+        // costs the same for any length. When it can't, the key is hashed whole
+        constexpr uint32_t key_digest(const char *p, size_t size, bool whole)
+        {
+            if (whole)
+            {
+                uint32_t h = 2166136261u;
+                for (size_t i = 0; i != size; i++)
+                    h = (h ^ uint8_t(p[i])) * 16777619u;
+                return h;
+            }
+
+            if (!size)
+                return 0;
+
+            return uint32_t(size) ^ uint32_t(uint8_t(p[0])) << 8 ^ uint32_t(uint8_t(p[size / 2])) << 16 ^
+                   uint32_t(uint8_t(p[size - 1])) << 24;
+        }
+
+        constexpr size_t ceil_log2(size_t n)
+        {
+            size_t bits = 0;
+            while ((size_t(1) << bits) < n)
+                bits++;
+            return bits;
+        }
+
+        // Perfect hash of a struct's keys, searched for at compile time: slot (digest * seed) >> shift
+        // holds the index + 1 of the only field whose key can be there. linear when no seed was found
+        template <size_t N>
+        struct key_table
+        {
+            static constexpr size_t kMinBits = ceil_log2(N * 2) ? ceil_log2(N * 2) : 1;
+            static constexpr size_t kMaxBits = kMinBits + 2;
+
+            uint32_t seed = 0;
+            uint32_t shift = 0;
+            bool whole = false;
+            bool linear = true;
+            uint16_t slots[size_t(1) << kMaxBits] = {};
+
+            constexpr size_t slot(const char *p, size_t size) const
+            {
+                return size_t((key_digest(p, size, whole) * seed) >> shift);
+            }
+        };
+
+        template <size_t N>
+        constexpr key_table<N> make_key_table(const std::array<std::string_view, N> &names)
+        {
+            key_table<N> table;
+            for (int whole = 0; whole != 2; whole++)
+            {
+                uint32_t digests[N ? N : 1] = {};
+                bool distinct = true;
+                for (size_t i = 0; i != N; i++)
+                {
+                    digests[i] = key_digest(names[i].data(), names[i].size(), whole);
+                    for (size_t j = 0; j != i; j++)
+                        distinct = distinct && digests[i] != digests[j];
+                }
+
+                if (!distinct)
+                    continue;
+
+                // a slot is taken when it holds the number of the current attempt
+                uint32_t stamp[size_t(1) << key_table<N>::kMaxBits] = {};
+                uint32_t attempt = 0;
+
+                for (size_t bits = key_table<N>::kMinBits; bits <= key_table<N>::kMaxBits; bits++)
+                {
+                    for (uint32_t k = 0; k != 256; k++)
+                    {
+                        uint32_t seed = (0x9E3779B1u * (k + 1)) | 1;
+                        uint32_t shift = uint32_t(32 - bits);
+
+                        attempt++;
+                        bool perfect = true;
+                        for (size_t i = 0; i != N && perfect; i++)
+                        {
+                            size_t h = size_t((digests[i] * seed) >> shift);
+                            perfect = stamp[h] != attempt;
+                            stamp[h] = attempt;
+                        }
+
+                        if (!perfect)
+                            continue;
+
+                        table.seed = seed;
+                        table.shift = shift;
+                        table.whole = whole;
+                        table.linear = false;
+                        for (size_t i = 0; i != N; i++)
+                            table.slots[(digests[i] * seed) >> shift] = uint16_t(i + 1);
+
+                        return table;
+                    }
+                }
+            }
+
+            return table;
+        }
+
+        template <class T, class = void>
+        struct is_described : std::false_type
+        {
+        };
+
+        template <class T>
+        struct is_described<T, std::void_t<decltype(ulib_json_fields((const T *)nullptr))>> : std::true_type
+        {
+        };
+
+        // The description of T, and its keys matched and dispatched without comparing them in turn
+        template <class T>
+        struct fields_of
+        {
+            static constexpr auto fields = ulib_json_fields((const T *)nullptr);
+            static constexpr size_t size = std::tuple_size_v<std::decay_t<decltype(fields)>>;
+
+            template <size_t... I>
+            static constexpr std::array<std::string_view, size> names(std::index_sequence<I...>)
+            {
+                return {std::string_view{std::get<I>(fields).name, std::get<I>(fields).size}...};
+            }
+
+            static constexpr std::array<std::string_view, size> kNames = names(std::make_index_sequence<size>{});
+            static constexpr key_table<size> kTable = make_key_table<size>(kNames);
+
+            // index of the field with this key, size if there is none
+            static size_t find(json::StringViewT key)
+            {
+                const char *p = key.data();
+                size_t n = key.size();
+                if (kTable.linear)
+                {
+                    for (size_t i = 0; i != size; i++)
+                        if (kNames[i].size() == n && memcmp(kNames[i].data(), p, n) == 0)
+                            return i;
+
+                    return size;
+                }
+
+                size_t i = size_t(kTable.slots[kTable.slot(p, n)]) - 1;
+                if (i < size && kNames[i].size() == n && memcmp(kNames[i].data(), p, n) == 0)
+                    return i;
+
+                return size;
+            }
+
+            using reader = bool (*)(json::parser &prsr, T &out, size_t depth);
+
+            template <size_t I>
+            static bool read_field(json::parser &prsr, T &out, size_t depth)
+            {
+                auto &member = out.*(std::get<I>(fields).member);
+                return value_reader<std::remove_reference_t<decltype(member)>>::read(prsr, member, depth);
+            }
+
+            template <size_t... I>
+            static constexpr std::array<reader, size> readers(std::index_sequence<I...>)
+            {
+                return {&read_field<I>...};
+            }
+
+            static constexpr std::array<reader, size> kReaders = readers(std::make_index_sequence<size>{});
+        };
+
+        template <class T, class>
+        struct value_reader
+        {
+            static_assert(sizeof(T) == 0, "no json reader for this type, describe it with ULIB_JSON_STRUCT");
+        };
+
+        template <>
+        struct value_reader<bool>
+        {
+            static bool read(json::parser &prsr, bool &out, size_t)
+            {
+                if (prsr.token() != 't' && prsr.token() != 'f')
+                    return prsr.wrong_type();
+
+                return prsr.scan_boolean(out);
+            }
+        };
+
+        // integral members only take integral numbers that fit them, anything else is wrong_type
+        template <class T>
+        struct value_reader<T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>>>
+        {
+            static bool fits(const number &num)
+            {
+                using limits = std::numeric_limits<T>;
+
+                switch (num.kind)
+                {
+                case number_kind::integer:
+                    if constexpr (std::is_signed_v<T>)
+                        return num.i >= int64_t(limits::min()) && num.i <= int64_t(limits::max());
+                    else
+                        return num.i >= 0 && uint64_t(num.i) <= uint64_t(limits::max());
+                case number_kind::unsigned_integer:
+                    return num.u <= uint64_t(limits::max());
+                default:
+                    // the bounds are exact powers of two, 2^63 itself doesn't fit an int64_t
+                    return num.d == std::trunc(num.d) && num.d >= double(limits::min()) &&
+                           num.d < double(limits::max() / 2 + 1) * 2;
+                }
+            }
+
+            static bool read(json::parser &prsr, T &out, size_t)
+            {
+                char ch = prsr.token();
+                if (ch != '-' && !(ch >= '0' && ch <= '9'))
+                    return prsr.wrong_type();
+
+                const char *at = prsr.mIt;
+                number num;
+                if (!prsr.scan_number(num))
+                    return false;
+
+                if constexpr (std::is_integral_v<T>)
+                {
+                    if (!fits(num))
+                        return prsr.fail(json::errc::wrong_type, at);
+                }
+
+                switch (num.kind)
+                {
+                case number_kind::integer:
+                    out = T(num.i);
+                    break;
+                case number_kind::unsigned_integer:
+                    out = T(num.u);
+                    break;
+                default:
+                    out = T(num.d);
+                    break;
+                }
+
+                return true;
+            }
+        };
+
+        template <class T>
+        struct value_reader<T, std::enable_if_t<is_string_v<T>>>
+        {
+            static bool read(json::parser &prsr, T &out, size_t)
+            {
+                if (prsr.token() != '\"')
+                    return prsr.wrong_type();
+
+                prsr.mIt++;
+                json::StringViewT str;
+                bool escaped;
+                if (!prsr.parse_quote_end_string(str, escaped))
+                    return false;
+
+                out = ulib::Convert<argument_encoding_or_die_t<T>>(ulib::u8(str));
+                prsr.advance();
+                return true;
+            }
+        };
+
+        template <class T>
+        struct value_reader<std::optional<T>>
+        {
+            static bool read(json::parser &prsr, std::optional<T> &out, size_t depth)
+            {
+                if (prsr.token() == 'n')
+                {
+                    out.reset();
+                    return prsr.scan_null();
+                }
+
+                if (!out)
+                    out.emplace();
+
+                return value_reader<T>::read(prsr, *out, depth);
+            }
+        };
+
+        template <class T>
+        struct is_sequence : std::false_type
+        {
+        };
+
+        template <class T, class AllocatorT>
+        struct is_sequence<std::vector<T, AllocatorT>> : std::true_type
+        {
+        };
+
+        template <class T, class AllocatorT>
+        struct is_sequence<ulib::List<T, AllocatorT>> : std::true_type
+        {
+        };
+
+        // elements are appended to a cleared container, which keeps its capacity
+        template <class ContainerT>
+        struct value_reader<ContainerT, std::enable_if_t<is_sequence<ContainerT>::value>>
+        {
+            static bool read(json::parser &prsr, ContainerT &out, size_t depth)
+            {
+                if (prsr.token() != '[')
+                    return prsr.wrong_type();
+                if (depth == prsr.mOptions.max_depth)
+                    return prsr.fail(json::errc::depth_exceeded, prsr.mIt);
+
+                out.clear();
+                prsr.advance(); // '['
+                if (prsr.token() == ']')
+                {
+                    prsr.advance();
+                    return true;
+                }
+
+                while (true)
+                {
+                    out.emplace_back();
+                    if (!value_reader<typename ContainerT::value_type>::read(prsr, out.back(), depth + 1))
+                        return false;
+
+                    if (prsr.token() == ',')
+                    {
+                        prsr.advance();
+                    }
+                    else if (prsr.token() == ']')
+                    {
+                        prsr.advance();
+                        return true;
+                    }
+                    else
+                    {
+                        return prsr.unexpected();
+                    }
+                }
+            }
+        };
+
+        // any value, built as a tree
+        template <>
+        struct value_reader<json>
+        {
+            static bool read(json::parser &prsr, json &out, size_t) { return prsr.parse_value(&out); }
+        };
+
+        template <class T>
+        struct value_reader<T, std::enable_if_t<is_described<T>::value>>
+        {
+            static bool read(json::parser &prsr, T &out, size_t depth)
+            {
+                using fields = fields_of<T>;
+
+                if (prsr.token() != '{')
+                    return prsr.wrong_type();
+                if (depth == prsr.mOptions.max_depth)
+                    return prsr.fail(json::errc::depth_exceeded, prsr.mIt);
+
+                prsr.advance(); // '{'
+                if (prsr.token() == '}')
+                {
+                    prsr.advance();
+                    return true;
+                }
+
+                while (true)
+                {
+                    if (prsr.token() != '\"')
+                        return prsr.unexpected();
+
+                    prsr.mIt++;
+                    json::StringViewT name;
+                    bool escaped;
+                    if (!prsr.parse_quote_end_string(name, escaped))
+                        return false;
+
+                    prsr.advance();
+                    if (prsr.token() != ':')
+                        return prsr.unexpected();
+
+                    prsr.advance();
+
+                    // a repeated key is read again, the last one wins
+                    size_t index = fields::find(name);
+                    bool ok = index != fields::size ? fields::kReaders[index](prsr, out, depth + 1) : prsr.skip_value();
+                    if (!ok)
+                        return false;
+
+                    if (prsr.token() == ',')
+                    {
+                        prsr.advance();
+                    }
+                    else if (prsr.token() == '}')
+                    {
+                        prsr.advance();
+                        return true;
+                    }
+                    else
+                    {
+                        return prsr.unexpected();
+                    }
+                }
+            }
+        };
+    } // namespace json_detail
+
+    // A member of a struct described for json::parser::parse_into and the key it is read from
+    template <class S, class M, size_t N>
+    constexpr json_detail::field<S, M> json_field(const char (&name)[N], M S::*member)
+    {
+        return json_detail::field<S, M>{name, N - 1, member};
+    }
+} // namespace ulib
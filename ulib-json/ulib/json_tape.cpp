@@ -0,0 +1,465 @@
+#include "json.h"
+#include "json_file.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace ulib
+{
+    using StringViewT = typename json::StringViewT;
+    using value_t = typename json::value_t;
+
+    // the parent of the root value
+    constexpr uint32_t kNoContainer = UINT32_MAX;
+
+    // sax handler writing the tape. While a container is open, its open word holds the index of
+    // the parent's open word instead of the final payload, the parent's count waits on a stack
+    // since it may exceed what a word holds
+    struct json::tape_document::builder
+    {
+        tape_document &doc;
+        duplicate_keys duplicates;
+        uint32_t open = kNoContainer;
+        // values and keys written into the open container
+        uint64_t count = 0;
+        // the counts of the containers enclosing the open one
+        std::vector<uint64_t> counts;
+
+        // the member being closed: key word index and the index after its value
+        struct member
+        {
+            uint32_t key;
+            uint32_t end;
+            // the member whose value is kept
+            uint32_t source;
+        };
+
+        // scratch kept across objects
+        std::vector<member> members;
+        std::vector<uint32_t> kept;
+        std::vector<uint32_t> table;
+        std::vector<uint64_t> moved;
+
+        builder(tape_document &doc, duplicate_keys duplicates) : doc(doc), duplicates(duplicates) {}
+
+        void append(uint64_t word)
+        {
+            if (doc.mTapeSize == doc.mTape.size())
+                doc.mTape.resize(doc.mTape.size() * 2 + 64);
+
+            doc.mTape.data()[doc.mTapeSize++] = word;
+        }
+
+        bool start(char tag)
+        {
+            counts.push_back(count + 1);
+            append(json_detail::tape_word(tag, open));
+            open = uint32_t(doc.mTapeSize - 1);
+            count = 0;
+            return true;
+        }
+
+        bool end(char tag, uint64_t size)
+        {
+            if (doc.mTapeSize + 1 >= kNoContainer)
+                throw json::exception(ulib::string{"json document is too large for a tape"});
+
+            uint64_t *word = doc.mTape.data() + open;
+            uint64_t saved = json_detail::tape_payload(*word);
+            size = std::min(size, json_detail::kTapeCountLimit);
+            *word = json_detail::tape_word(json_detail::tape_tag(*word), (size << 32) | (doc.mTapeSize + 1));
+            append(json_detail::tape_word(tag, open));
+
+            open = uint32_t(saved);
+            count = counts.back();
+            counts.pop_back();
+            return true;
+        }
+
+        bool text(StringViewT str)
+        {
+            if (str.size() > UINT32_MAX)
+                throw json::exception(ulib::string{"json string is too long: "} + std::to_string(str.size()) +
+                                      " bytes");
+
+            uint32_t size = uint32_t(str.size());
+            size_t offset = doc.mStringsSize;
+            size_t needed = offset + sizeof(size) + size;
+            if (needed > doc.mStrings.size())
+                doc.mStrings.resize(std::max(needed, doc.mStrings.size() * 2));
+
+            char *out = doc.mStrings.data() + offset;
+            memcpy(out, &size, sizeof(size));
+            memcpy(out + sizeof(size), str.data(), size);
+            doc.mStringsSize = needed;
+
+            count++;
+            append(json_detail::tape_word('\"', offset));
+            return true;
+        }
+
+        bool number(char tag, uint64_t bits)
+        {
+            count++;
+            append(json_detail::tape_word(tag, 0));
+            append(bits);
+            return true;
+        }
+
+        StringViewT key_at(uint32_t index) const
+        {
+            const char *str = doc.mStrings.data() + json_detail::tape_payload(doc.mTape.data()[index]);
+            uint32_t size;
+            memcpy(&size, str, sizeof(size));
+            return StringViewT{str + sizeof(size), size};
+        }
+
+        // Applies the duplicate policy to the members of the open object like the tree parser does:
+        // the first position is kept and, with last_wins, given the last value. Members after a
+        // dropped one are moved down, the indices inside their values are shifted with them.
+        // Returns the number of members left
+        uint64_t resolve_duplicates()
+        {
+            const uint64_t *tape = doc.mTape.data();
+            members.clear();
+            for (size_t index = open + 1; index != doc.mTapeSize;)
+            {
+                size_t end = json_detail::tape_next(tape, index + 1);
+                members.push_back({uint32_t(index), uint32_t(end), uint32_t(members.size())});
+                index = end;
+            }
+
+            size_t size = members.size();
+
+            // small objects are cheaper to check pairwise than to hash
+            constexpr size_t kLinearLimit = 8;
+
+            size_t mask = 0;
+            if (size > kLinearLimit)
+            {
+                size_t capacity = 16;
+                while (capacity < size * 2)
+                    capacity <<= 1;
+
+                table.assign(capacity, 0);
+                mask = capacity - 1;
+            }
+
+            kept.clear();
+            for (size_t read = 0; read != size; read++)
+            {
+                StringViewT key = key_at(members[read].key);
+
+                size_t found = size;
+                size_t slot = 0;
+                if (mask)
+                {
+                    slot = json_detail::hash_key(key.data(), key.size()) & mask;
+                    for (; table[slot]; slot = (slot + 1) & mask)
+                    {
+                        if (key_at(members[table[slot] - 1].key) == key)
+                        {
+                            found = table[slot] - 1;
+                            break;
+                        }
+                    }
+                }
+                else
+                {
+                    for (uint32_t i : kept)
+                    {
+                        if (key_at(members[i].key) == key)
+                        {
+                            found = i;
+                            break;
+                        }
+                    }
+                }
+
+                if (found == size)
+                {
+                    if (mask)
+                        table[slot] = uint32_t(read + 1);
+                    kept.push_back(uint32_t(read));
+                    continue;
+                }
+
+                if (duplicates == duplicate_keys::reject)
+                    throw ParseError{ulib::string{errc_to_string(errc::duplicate_key)}};
+                if (duplicates == duplicate_keys::last_wins)
+                    members[found].source = uint32_t(read);
+            }
+
+            if (kept.size() == size)
+                return size;
+
+            moved.clear();
+            for (uint32_t i : kept)
+            {
+                const member &value = members[members[i].source];
+                moved.push_back(tape[members[i].key]);
+
+                size_t first = value.key + 1;
+                int64_t shift = int64_t(open + 1 + moved.size()) - int64_t(first);
+                for (size_t index = first; index != value.end; index++)
+                {
+                    uint64_t word = tape[index];
+                    switch (json_detail::tape_tag(word))
+                    {
+                    case '{':
+                    case '[':
+                        word = (word & ~uint64_t(UINT32_MAX)) | uint32_t(int64_t(uint32_t(word)) + shift);
+                        break;
+                    case '}':
+                    case ']':
+                        word = json_detail::tape_word(json_detail::tape_tag(word),
+                                                      uint64_t(int64_t(json_detail::tape_payload(word)) + shift));
+                        break;
+                    case 'l':
+                    case 'u':
+                    case 'd':
+                        moved.push_back(word);
+                        word = tape[++index];
+                        break;
+                    }
+
+                    moved.push_back(word);
+                }
+            }
+
+            memcpy(doc.mTape.data() + open + 1, moved.data(), moved.size() * sizeof(uint64_t));
+            doc.mTapeSize = open + 1 + moved.size();
+            return kept.size();
+        }
+
+        bool start_object() { return start('{'); }
+
+        // a member counts its key and its value
+        bool end_object()
+        {
+            uint64_t size = count / 2;
+            if (duplicates != duplicate_keys::keep_all && size > 1)
+                size = resolve_duplicates();
+
+            return end('}', size);
+        }
+
+        bool start_array() { return start('['); }
+        bool end_array() { return end(']', count); }
+        bool key(StringViewT name) { return text(name); }
+        bool string(StringViewT str) { return text(str); }
+        bool integer(int64_t value) { return number('l', uint64_t(value)); }
+        bool unsigned_integer(uint64_t value) { return number('u', value); }
+
+        bool floating(double value)
+        {
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            return number('d', bits);
+        }
+
+        bool boolean(bool value)
+        {
+            count++;
+            append(json_detail::tape_word(value ? 't' : 'f', 0));
+            return true;
+        }
+
+        bool null()
+        {
+            count++;
+            append(json_detail::tape_word('n', 0));
+            return true;
+        }
+    };
+
+    void json::tape_document::parse(StringViewT str) { parse(str, parse_options{}); }
+
+    void json::tape_document::parse(StringViewT str, const parse_options &options)
+    {
+        mTapeSize = 0;
+        mStringsSize = 0;
+
+        // about one word per 8 bytes of input to start with, both buffers double when they fill up
+        if (mTape.size() < str.size() / 8)
+            mTape.resize(str.size() / 8 + 64);
+
+        parser prsr{options};
+        builder out{*this, options.duplicates};
+
+        try
+        {
+            prsr.sax_parse(str, out);
+        }
+        catch (...)
+        {
+            mTapeSize = 0;
+            mStringsSize = 0;
+            throw;
+        }
+    }
+
+    void json::tape_document::parse_file(const std::filesystem::path &path) { parse_file(path, parse_options{}); }
+
+    void json::tape_document::parse_file(const std::filesystem::path &path, const parse_options &options)
+    {
+        json_detail::mapped_file file{path};
+        parse(StringViewT{file.data(), file.size()}, options);
+    }
+
+    json_view json::tape_document::root() const
+    {
+        if (!mTapeSize)
+            throw exception{ulib::string{"json tape_document is empty"}};
+
+        return json_view{mTape.data(), mStrings.data(), 0};
+    }
+
+    json_view json::tape_document::operator[](StringViewT name) const { return root()[name]; }
+    json_view json::tape_document::operator[](size_t idx) const { return root()[idx]; }
+
+    json::value_t json_view::type() const
+    {
+        switch (tag())
+        {
+        case '{':
+            return value_t::object;
+        case '[':
+            return value_t::array;
+        case '\"':
+            return value_t::string;
+        case 'l':
+            return value_t::integer;
+        case 'u':
+            return value_t::unsigned_integer;
+        case 'd':
+            return value_t::floating;
+        case 't':
+        case 'f':
+            return value_t::boolean;
+        default:
+            return value_t::null;
+        }
+    }
+
+    json_view json_view::operator[](StringViewT name) const
+    {
+        if (!is_object())
+            throw json::exception{ulib::string{"in json_view[\""} + name + "\"]" + " json must be an object"};
+
+        auto found = find(name);
+        if (!found)
+            throw json::exception{ulib::string{"in json_view[\""} + name + "\"]" + " key not found"};
+
+        return *found;
+    }
+
+    json_view json_view::operator[](size_t idx) const
+    {
+        if (!is_array())
+            throw json::exception{ulib::string{"in json_view["} + std::to_string(idx) + "]" +
+                                  " json must be an array"};
+
+        size_t end = size_t(uint32_t(mTape[mIndex])) - 1;
+        size_t index = mIndex + 1;
+        for (size_t i = 0; i != idx && index != end; i++)
+            index = json_detail::tape_next(mTape, index);
+
+        if (index == end)
+            throw json::exception{ulib::string{"in json_view["} + std::to_string(idx) + "]" +
+                                  " index out of range"};
+
+        return json_view{mTape, mStrings, index};
+    }
+
+    std::optional<json_view> json_view::find(StringViewT name) const
+    {
+        if (!is_object())
+            return std::nullopt;
+
+        for (auto &item : items())
+        {
+            if (item.name() == name)
+                return item.value();
+        }
+
+        return std::nullopt;
+    }
+
+    json_view::range<json_view::item_iterator> json_view::items() const
+    {
+        if (!is_object())
+            throw json::exception(ulib::string{"json_view must be an object while items(). current: "} +
+                                  json::type_to_string(type()));
+
+        size_t end = size_t(uint32_t(mTape[mIndex])) - 1;
+        return {item_iterator{json_view{mTape, mStrings, mIndex + 1}}, item_iterator{json_view{mTape, mStrings, end}}};
+    }
+
+    json_view::range<json_view::value_iterator> json_view::values() const
+    {
+        if (!is_array())
+            throw json::exception(ulib::string{"json_view must be an array while values(). current: "} +
+                                  json::type_to_string(type()));
+
+        size_t end = size_t(uint32_t(mTape[mIndex])) - 1;
+        return {value_iterator{json_view{mTape, mStrings, mIndex + 1}}, value_iterator{json_view{mTape, mStrings, end}}};
+    }
+
+    size_t json_view::size() const
+    {
+        if (!is_object() && !is_array())
+            throw json::exception(ulib::string{"json_view must be an object or an array while size(). current: "} +
+                                  json::type_to_string(type()));
+
+        uint64_t count = json_detail::tape_payload(mTape[mIndex]) >> 32;
+        if (count != json_detail::kTapeCountLimit)
+            return size_t(count);
+
+        size_t end = size_t(uint32_t(mTape[mIndex])) - 1;
+        size_t size = 0;
+        for (size_t index = mIndex + 1; index != end; size++)
+            index = json_detail::tape_next(mTape, is_object() ? index + 1 : index);
+
+        return size;
+    }
+
+    json json_view::value() const
+    {
+        switch (tag())
+        {
+        case '{': {
+            // repeated keys were resolved by the builder, any left are kept like keep_all keeps them
+            json out{value_t::object};
+            for (auto &item : items())
+            {
+                out.mObject->emplace_back(item.name()).value() = item.value().value();
+                out.mObject->appended();
+            }
+
+            return out;
+        }
+        case '[': {
+            json out{value_t::array};
+            for (auto &element : values())
+                out.push_back() = element.value();
+
+            return out;
+        }
+        case '\"':
+            return json(get<StringViewT>());
+        case 'l':
+            return json(get<int64_t>());
+        case 'u':
+            return json(get<uint64_t>());
+        case 'd':
+            return json(get<double>());
+        case 't':
+        case 'f':
+            return json(get<bool>());
+        default:
+            return json{};
+        }
+    }
+
+} // namespace ulib
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace ulib
+{
+    namespace json_detail
+    {
+        // A tape word holds its tag in the high byte and a payload in the low 56 bits:
+        //   '{' '[': the index after the matching close word in the low 32 bits, the number of
+        //            members or elements in the next 24 (kTapeCountLimit when there are more)
+        //   '}' ']': the index of the open word
+        //   '"':     the offset of the string in the string buffer, where its uint32 size precedes it
+        //   'l' 'u' 'd': int64, uint64 or double, the value is the next word
+        //   't' 'f' 'n'
+        // Object members are a '"' key word followed by the value
+        constexpr uint64_t kTapePayloadMask = (uint64_t(1) << 56) - 1;
+        constexpr uint64_t kTapeCountLimit = 0xFFFFFF;
+
+        inline uint64_t tape_word(char tag, uint64_t payload) { return (uint64_t(uint8_t(tag)) << 56) | payload; }
+        inline char tape_tag(uint64_t word) { return char(word >> 56); }
+        inline uint64_t tape_payload(uint64_t word) { return word & kTapePayloadMask; }
+
+        // the index after the value at index
+        inline size_t tape_next(const uint64_t *tape, size_t index)
+        {
+            switch (tape_tag(tape[index]))
+            {
+            case '{':
+            case '[':
+                return size_t(uint32_t(tape[index]));
+            case 'l':
+            case 'u':
+            case 'd':
+                return index + 2;
+            default:
+                return index + 1;
+            }
+        }
+
+        inline double tape_double(uint64_t word)
+        {
+            double d;
+            memcpy(&d, &word, sizeof(d));
+            return d;
+        }
+
+    } // namespace json_detail
+} // namespace ulib
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace ulib
+{
+    namespace json_detail
+    {
+        constexpr uint32_t kReplacementCharacter = 0xFFFD;
+
+        inline bool is_high_surrogate(uint32_t unit) { return unit >= 0xD800 && unit <= 0xDBFF; }
+        inline bool is_low_surrogate(uint32_t unit) { return unit >= 0xDC00 && unit <= 0xDFFF; }
+
+        inline int hex_digit(char ch)
+        {
+            if (ch >= '0' && ch <= '9')
+                return ch - '0';
+            if (ch >= 'a' && ch <= 'f')
+                return ch - 'a' + 10;
+            if (ch >= 'A' && ch <= 'F')
+                return ch - 'A' + 10;
+            return -1;
+        }
+
+        // The code unit of the 4 hex digits at p, -1 if one of them isn't a hex digit
+        inline int32_t parse_hex4(const char *p)
+        {
+            int32_t unit = 0;
+            for (int i = 0; i != 4; i++)
+            {
+                int digit = hex_digit(p[i]);
+                if (digit < 0)
+                    return -1;
+
+                unit = (unit << 4) | digit;
+            }
+
+            return unit;
+        }
+
+        inline uint32_t combine_surrogates(uint32_t high, uint32_t low)
+        {
+            return 0x10000 + ((high - 0xD800) << 10) + (low - 0xDC00);
+        }
+
+        // Writes cp as UTF-8, returns the length: 1 to 4 bytes
+        inline size_t encode_utf8(uint32_t cp, char *out)
+        {
+            if (cp < 0x80)
+            {
+                out[0] = char(cp);
+                return 1;
+            }
+
+            if (cp < 0x800)
+            {
+                out[0] = char(0xC0 | (cp >> 6));
+                out[1] = char(0x80 | (cp & 0x3F));
+                return 2;
+            }
+
+            if (cp < 0x10000)
+            {
+                out[0] = char(0xE0 | (cp >> 12));
+                out[1] = char(0x80 | ((cp >> 6) & 0x3F));
+                out[2] = char(0x80 | (cp & 0x3F));
+                return 3;
+            }
+
+            out[0] = char(0xF0 | (cp >> 18));
+            out[1] = char(0x80 | ((cp >> 12) & 0x3F));
+            out[2] = char(0x80 | ((cp >> 6) & 0x3F));
+            out[3] = char(0x80 | (cp & 0x3F));
+            return 4;
+        }
+
+    } // namespace json_detail
+} // namespace ulib